@@ -1,19 +1,26 @@
 #include "ClientHandler.h"
 #include "NovusTypes.h"
-#include "Utils/Timer.h"
 #include "Networking/Opcode/Opcode.h"
 #include "Config\ConfigHandler.h"
 #include "Scripting/ScriptHandler.h"
+#include "Scripting/ScriptCache.h"
+#include "Scripting/Coroutines.h"
+#include "Scripting/ScriptProfiler.h"
+#include "Cryptography/SRP6EphemeralPool.h"
+#include "Networking/BufferPool.h"
+#include "Connection/AuthTimings.h"
+#include "Connection/RealmList.h"
+#include "Utils/DebugHandler.h"
 
 #include <thread>
 #include <iostream>
 
 ClientHandler::ClientHandler(f32 targetTickRate)
     : _isRunning(false)
+    , _tickScheduler(targetTickRate)
     , _inputQueue(256)
     , _outputQueue(256)
 {
-    _targetTickRate = targetTickRate;
 }
 
 ClientHandler::~ClientHandler()
@@ -52,33 +59,47 @@ void ClientHandler::Stop()
 void ClientHandler::Run()
 {
 	std::string scriptDirectory = ConfigHandler::GetOption<std::string>("path", "scripts");
+	ScriptCache::SetDirectory(ConfigHandler::GetOption<std::string>("scriptCachePath", "scriptcache"));
 	ScriptHandler::SetIOService(_ioService);
+	ScriptHandler::SetLoadTimesPath(ConfigHandler::GetOption<std::string>("scriptLoadTimesPath", ""));
+
+	// Started before loading so the main functions show up in the profile as well
+	_scriptProfilePath = ConfigHandler::GetOption<std::string>("scriptProfilePath", "scriptprofile");
+	ScriptProfiler::SetSampleInterval(ConfigHandler::GetOption<u32>("scriptProfileInterval", 100));
+	if (ConfigHandler::GetOption<bool>("scriptProfile", false))
+		ScriptProfiler::Start();
+
 	ScriptHandler::LoadScriptDirectory(scriptDirectory);
+	SRP6EphemeralPool::Start(_ioService);
+	_botSwarm.Start(_ioService);
+
+	TickOverrunPolicy overrunPolicy = TICK_OVERRUN_CATCH_UP;
+	std::string overrunPolicyName = ConfigHandler::GetOption<std::string>("tickOverrunPolicy", "catchup");
+	if (!TickScheduler::ParsePolicy(overrunPolicyName, overrunPolicy))
+	{
+		NC_LOG_WARNING("Unknown tickOverrunPolicy '%s', catching up instead", overrunPolicyName.c_str());
+	}
+	_tickScheduler.SetOverrunPolicy(overrunPolicy, ConfigHandler::GetOption<u32>("tickMaxCatchUp", 5));
+
+    // Arrivals are checked while waiting as well so open loop sessions start within a millisecond of their schedule
+    std::chrono::milliseconds idleInterval(_botSwarm.GetArrivalScheduler() ? 1 : 0);
 
-    Timer timer;
+    _tickScheduler.Start();
     while (true)
     {
-        f32 deltaTime = timer.GetDeltaTime();
-        timer.Tick();
-
+        _tickScheduler.BeginTick();
         if (!Update())
             break;
+        _tickScheduler.EndTick();
 
-        // Wait for tick rate, this might be an overkill implementation but it has the even tickrate I've seen - MPursche
-        f32 targetDelta = 1.0f / _targetTickRate;
-
-        for (deltaTime = timer.GetDeltaTime(); deltaTime < targetDelta - 0.0025f; deltaTime = timer.GetDeltaTime())
-        {
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
-        }
-
-        for (deltaTime = timer.GetDeltaTime(); deltaTime < targetDelta; deltaTime = timer.GetDeltaTime())
-        {
-            std::this_thread::yield();
-        }
+        _tickScheduler.WaitForTick(idleInterval, [this]() { _botSwarm.UpdateArrivals(); });
     }
 
     // Clean up stuff here
+    _botSwarm.Stop();
+
+    if (ScriptProfiler::IsRunning())
+        ScriptProfiler::Dump(_scriptProfilePath);
 
     Message exitMessage;
     exitMessage.code = MSG_OUT_EXIT_CONFIRM;
@@ -100,7 +121,7 @@ bool ClientHandler::Update()
         {
             Message pongMessage;
             pongMessage.code = MSG_OUT_PRINT;
-            pongMessage.message = new std::string("PONG!");
+            pongMessage.SetText("PONG!", 5);
             _outputQueue.enqueue(pongMessage);
         }
 
@@ -108,7 +129,81 @@ bool ClientHandler::Update()
 		{
 			ScriptHandler::ReloadScripts();
 		}
+
+        if (message.code == MSG_IN_SWARM_STATUS)
+        {
+            LatencySummary tickDuration;
+            LatencySummary tickLateness;
+            _tickScheduler.GetTickDuration(tickDuration);
+            _tickScheduler.GetTickLateness(tickLateness);
+            PrintMessage("Ticks: %.2f/%.0f Hz, duration p50=%.2fms p99=%.2fms max=%.2fms, late p50=%.2fms p99=%.2fms, %llu overruns, %llu skipped (%s)", _tickScheduler.GetMeasuredRate(), _tickScheduler.GetTickRate(), tickDuration.p50 / 1000.0, tickDuration.p99 / 1000.0, tickDuration.max / 1000.0, tickLateness.p50 / 1000.0, tickLateness.p99 / 1000.0, _tickScheduler.GetOverruns(), _tickScheduler.GetSkippedTicks(), TickScheduler::GetPolicyName(_tickScheduler.GetOverrunPolicy()));
+
+            if (_botSwarm.IsEnabled())
+            {
+                BotSwarmStatus status;
+                _botSwarm.GetStatus(status);
+                PrintMessage("Swarm: %u/%u spawned, %u connecting, %u challenge, %u proof, %u authed, %u closed, %u packets queued", status.spawned, _botSwarm.GetBotCount(), status.connecting, status.challenge, status.proof, status.authed, status.closed, status.queued);
+                PrintMessage("World: %u connecting, %u authed, %u closed", status.worldConnecting, status.worldAuthed, status.worldClosed);
+                PrintMessage("SRP6: %u ephemerals ready, %llu hits, %llu misses", (u32)SRP6EphemeralPool::GetAvailable(), SRP6EphemeralPool::GetHits(), SRP6EphemeralPool::GetMisses());
+                PrintMessage("Buffers: %llu hits, %llu misses, %llu oversized", BufferPool::GetHits(), BufferPool::GetMisses(), BufferPool::GetOversized());
+
+                if (ArrivalScheduler const* arrivals = _botSwarm.GetArrivalScheduler())
+                {
+                    LatencySummary startLag;
+                    arrivals->GetStartLag(startLag);
+                    PrintMessage("Arrivals: %s at %.1f/s, %llu started, %u in flight, start lag p50=%.2fms p99=%.2fms", ArrivalScheduler::GetModeName(arrivals->GetSchedule().mode), arrivals->GetCurrentRate(), arrivals->GetStarted(), status.connecting + status.challenge + status.proof, startLag.p50 / 1000.0, startLag.p99 / 1000.0);
+                }
+
+                CoroutineStatus coroutines;
+                CoroutineScheduler::GetStatus(coroutines);
+                PrintMessage("Coroutines: %u running, %u sleeping, %u waiting for packets, %u contexts pooled", coroutines.running, coroutines.sleeping, coroutines.waiting, coroutines.pooledContexts);
+
+                if (ReplayCapture const* replay = _botSwarm.GetReplay())
+                {
+                    if (replay->GetTimeScale() > 0.0)
+                    {
+                        PrintMessage("Replay: %llu/%llu packets sent at %.2fx", replay->GetSentPackets(), replay->GetPacketCount(), replay->GetTimeScale());
+                    }
+                    else
+                    {
+                        PrintMessage("Replay: %llu/%llu packets sent as fast as possible", replay->GetSentPackets(), replay->GetPacketCount());
+                    }
+                }
+            }
+            else
+            {
+                PrintMessage("Swarm: Not enabled");
+            }
+        }
+
+        if (message.code == MSG_IN_PROFILE_START)
+        {
+            ScriptProfiler::Start();
+        }
+
+        if (message.code == MSG_IN_PROFILE_STOP)
+        {
+            ScriptProfiler::Stop();
+        }
+
+        if (message.code == MSG_IN_PROFILE_DUMP)
+        {
+            ScriptProfiler::Dump(_scriptProfilePath);
+        }
+
+        if (message.code == MSG_IN_PROFILE_RESET)
+        {
+            ScriptProfiler::Reset();
+        }
+
+        if (message.code == MSG_IN_AUTH_STATS)
+        {
+            AuthTimings::Print([this](auto... args) { PrintMessage(args...); });
+            PrintMessage("Realmlist cache: %llu hits, %llu misses", RealmListCache::GetHits(), RealmListCache::GetMisses());
+        }
     }
 
+    _botSwarm.Update();
+    CoroutineScheduler::Update();
     return true;
 }
\ No newline at end of file
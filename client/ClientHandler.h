@@ -25,6 +25,8 @@
 #include "NovusTypes.h"
 #include "Message.h"
 #include "Utils/ConcurrentQueue.h"
+#include "Swarm/BotSwarm.h"
+#include "Utils/TickScheduler.h"
 #include <asio.hpp>
 
 enum InputMessages
@@ -33,7 +35,13 @@ enum InputMessages
 	MSG_IN_PING,
     MSG_IN_SET_CONNECTION,
     MSG_IN_FOWARD_PACKET,
-	MSG_IN_RELOAD_SCRIPTS
+	MSG_IN_RELOAD_SCRIPTS,
+	MSG_IN_SWARM_STATUS,
+	MSG_IN_AUTH_STATS,
+	MSG_IN_PROFILE_START,
+	MSG_IN_PROFILE_STOP,
+	MSG_IN_PROFILE_DUMP,
+	MSG_IN_PROFILE_RESET
 };
 
 enum OutputMessages
@@ -63,7 +71,7 @@ public:
 
         Message printMessage;
         printMessage.code = MSG_OUT_PRINT;
-        printMessage.message = new std::string(str);
+        printMessage.SetText(str, length);
         _outputQueue.enqueue(printMessage);
     }
 
@@ -74,9 +82,11 @@ private:
 
 private:
 	bool _isRunning;
-    f32 _targetTickRate;
+    TickScheduler _tickScheduler;
 
 	moodycamel::ConcurrentQueue<Message> _inputQueue;
 	moodycamel::ConcurrentQueue<Message> _outputQueue;
 	asio::io_service* _ioService;
+	BotSwarm _botSwarm;
+	std::string _scriptProfilePath;
 };
\ No newline at end of file
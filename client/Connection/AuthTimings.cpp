@@ -0,0 +1,42 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+
+#include "AuthTimings.h"
+
+LatencyHistogram AuthTimings::_histograms[AUTHTIMING_COUNT];
+
+char const* AuthTimings::GetStageName(AuthTimingStage stage)
+{
+    switch (stage)
+    {
+        case AUTHTIMING_CONNECT: return "Connect";
+        case AUTHTIMING_CHALLENGE_RTT: return "Challenge RTT";
+        case AUTHTIMING_SRP_COMPUTE: return "SRP compute";
+        case AUTHTIMING_PROOF_RTT: return "Proof RTT";
+        case AUTHTIMING_REALMLIST_RTT: return "Realmlist RTT";
+        case AUTHTIMING_WORLD_CONNECT: return "World connect";
+        case AUTHTIMING_WORLD_AUTH_RTT: return "World auth RTT";
+        default: return "Unknown";
+    }
+}
\ No newline at end of file
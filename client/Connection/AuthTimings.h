@@ -0,0 +1,75 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include <chrono>
+#include "../NovusTypes.h"
+#include "../Utils/LatencyHistogram.h"
+
+enum AuthTimingStage
+{
+    AUTHTIMING_CONNECT,
+    AUTHTIMING_CHALLENGE_RTT,
+    AUTHTIMING_SRP_COMPUTE,
+    AUTHTIMING_PROOF_RTT,
+    AUTHTIMING_REALMLIST_RTT,
+    AUTHTIMING_WORLD_CONNECT,
+    AUTHTIMING_WORLD_AUTH_RTT,
+    AUTHTIMING_COUNT
+};
+
+// Process wide login latency histograms in microseconds, every connection records into the same histograms
+class AuthTimings
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    static void Record(AuthTimingStage stage, Clock::time_point start, Clock::time_point end)
+    {
+        _histograms[stage].Record(static_cast<u64>(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()));
+    }
+
+    static void GetSummary(AuthTimingStage stage, LatencySummary& summary) { _histograms[stage].GetSummary(summary); }
+    static char const* GetStageName(AuthTimingStage stage);
+
+    // Calls printer with one preformatted line per stage so both the console and the tick thread can use it
+    template <typename Printer>
+    static void Print(Printer printer)
+    {
+        for (u32 i = 0; i < AUTHTIMING_COUNT; i++)
+        {
+            AuthTimingStage stage = static_cast<AuthTimingStage>(i);
+
+            LatencySummary summary;
+            GetSummary(stage, summary);
+            printer("%-14s n=%llu p50=%.2fms p90=%.2fms p99=%.2fms p99.9=%.2fms max=%.2fms", GetStageName(stage), summary.count,
+                summary.p50 / 1000.0, summary.p90 / 1000.0, summary.p99 / 1000.0, summary.p999 / 1000.0, summary.max / 1000.0);
+        }
+    }
+
+private:
+    AuthTimings() { }
+
+    static LatencyHistogram _histograms[AUTHTIMING_COUNT];
+};
\ No newline at end of file
@@ -26,51 +26,146 @@
 #include "../Networking\ByteBuffer.h"
 #include "../Utils/DebugHandler.h"
 #include "../Cryptography/SHA1.h"
+#include "../Cryptography/SRP6EphemeralPool.h"
+#include "AuthTimings.h"
+#include "../Networking/PacketRecorder.h"
 #include "../Scripting/PacketHooks.h"
+#include "../Config/ConfigHandler.h"
+#include <mutex>
 
-robin_hood::unordered_map<u8, NovusMessageHandler> NovusConnection::InitMessageHandlers()
+constexpr NovusMessageHandlerTable NovusConnection::InitMessageHandlers()
 {
-    robin_hood::unordered_map<u8, NovusMessageHandler> messageHandlers;
+    NovusMessageHandlerTable messageHandlers;
 
-    messageHandlers[NOVUS_CHALLENGE] =  { NOVUSSTATUS_CHALLENGE,    3,  &NovusConnection::HandleCommandChallenge };
-    messageHandlers[NOVUS_PROOF]     =  { NOVUSSTATUS_PROOF,        4,  &NovusConnection::HandleCommandProof };
+    messageHandlers.Register(NOVUS_CHALLENGE,  { &NovusConnection::HandleCommandChallenge, NOVUSSTATUS_CHALLENGE,   3, OPCODE_DIRECTION_BOTH });
+    messageHandlers.Register(NOVUS_PROOF,      { &NovusConnection::HandleCommandProof,     NOVUSSTATUS_PROOF,       4, OPCODE_DIRECTION_BOTH });
+    messageHandlers.Register(NOVUS_REALM_LIST, { &NovusConnection::HandleCommandRealmList, NOVUSSTATUS_AUTHED,      3, OPCODE_DIRECTION_BOTH });
 
     return messageHandlers;
 }
-robin_hood::unordered_map<u8, NovusMessageHandler> const MessageHandlers = NovusConnection::InitMessageHandlers();
+constexpr NovusMessageHandlerTable MessageHandlers = NovusConnection::InitMessageHandlers();
+static_assert(MessageHandlers.Accepts(OPCODE_DIRECTION_SERVER), "The auth handler table may only contain commands the authserver sends");
 
-bool NovusConnection::Start(std::string username, std::string password)
+NovusConnection::~NovusConnection()
+{
+    delete _worldConnection.load();
+}
+
+bool NovusConnection::GetEndpoint(std::string const& address, u16 port, asio::ip::tcp::endpoint& endpoint)
 {
-    try
+    // Every bot connects to the same authserver, so only the first connection pays for the resolve
+    static std::mutex endpointMutex;
+    static robin_hood::unordered_map<std::string, asio::ip::tcp::endpoint> endpointCache;
+
+    std::string key = address + ":" + std::to_string(port);
+
+    std::lock_guard<std::mutex> lock(endpointMutex);
+    auto itr = endpointCache.find(key);
+    if (itr != endpointCache.end())
     {
-        _socket->connect(asio::ip::tcp::endpoint(asio::ip::address::from_string(_address), _port));
+        endpoint = itr->second;
+        return true;
+    }
 
-        cAuthLogonChallenge challenge(username);
-        u32 challengeSize = 34 + (u32)username.length();
+    asio::io_service resolverService;
+    asio::ip::tcp::resolver resolver(resolverService);
 
-        ByteBuffer packet(challenge.size);
-        packet.Resize(challengeSize);
-        std::memcpy(packet.data(), &challenge, challengeSize);
-        packet.WriteBytes(challengeSize);
+    asio::error_code error;
+    asio::ip::tcp::resolver::results_type results = resolver.resolve(asio::ip::tcp::v4(), address, std::to_string(port), error);
+    if (error || results.empty())
+    {
+        NC_LOG_ERROR("Failed to resolve %s: %s", key.c_str(), error.message().c_str());
+        return false;
+    }
 
-        AsyncRead();
-        Send(packet);
+    endpoint = results.begin()->endpoint();
+    endpointCache[key] = endpoint;
+    return true;
+}
+
+bool NovusConnection::Start(std::string username, std::string password)
+{
+    static const u32 connectTimeout = ConfigHandler::GetOption<u32>("connectTimeout", 10000);
 
-        _username = username;
-        _password = password;
+    asio::ip::tcp::endpoint endpoint;
+    if (!GetEndpoint(_address, _port, endpoint))
+        return false;
 
-        // Hash password
-        SHA1Hasher passwordHash;
-        passwordHash.UpdateHash(_username + ":" + _password);
-        passwordHash.Finish();
-        _passwordKey->Bin2BN(passwordHash.GetData(), 20);
-        return true;
+    _username = username;
+
+    // Hash password, only the hash is kept around so we don't hold on to the plain text password per connection
+    SHA1Hasher passwordHash;
+    passwordHash.UpdateHash(_username + ":" + password);
+    passwordHash.Finish();
+    _passwordKey.Bin2BN(passwordHash.GetData(), 20);
+
+    _status = NOVUSSTATUS_CONNECTING;
+
+    // The timer only lives while connecting, a connected bot doesn't carry it around
+    _connectTimer = std::make_unique<asio::steady_timer>(_socket->get_executor().context());
+    _connectTimer->expires_after(std::chrono::milliseconds(connectTimeout));
+    _connectTimer->async_wait(asio::bind_executor(_strand, std::bind(&NovusConnection::HandleConnectTimeout, this, std::placeholders::_1)));
+
+    _stageStart = AuthTimings::Clock::now();
+    _socket->async_connect(endpoint, asio::bind_executor(_strand, std::bind(&NovusConnection::HandleConnect, this, std::placeholders::_1)));
+    return true;
+}
+
+void NovusConnection::HandleConnect(asio::error_code error)
+{
+    if (_connectTimer)
+    {
+        _connectTimer->cancel();
+        _connectTimer.reset();
     }
-    catch (asio::system_error error)
+
+    // The connect timed out or the connection was closed while connecting
+    if (_status != NOVUSSTATUS_CONNECTING)
+        return;
+
+    if (error)
     {
-        NC_LOG_FATAL(error.what());
-        return false;
+        NC_LOG_ERROR("[%s] Failed to connect to %s:%u: %s", _username.c_str(), _address.c_str(), (u32)_port, error.message().c_str());
+        Close(error);
+        return;
     }
+
+    AuthTimings::Clock::time_point now = AuthTimings::Clock::now();
+    AuthTimings::Record(AUTHTIMING_CONNECT, _stageStart, now);
+    _stageStart = now;
+
+    cAuthLogonChallenge challenge(_username);
+    u32 challengeSize = 34 + (u32)_username.length();
+
+    ByteBuffer packet(challenge.size);
+    packet.Resize(challengeSize);
+    std::memcpy(packet.data(), &challenge, challengeSize);
+    packet.WriteBytes(challengeSize);
+
+    _status = NOVUSSTATUS_CHALLENGE;
+    AsyncRead();
+    SendCommand(std::move(packet));
+}
+
+void NovusConnection::HandleConnectTimeout(asio::error_code error)
+{
+    if (error == asio::error::operation_aborted || _status != NOVUSSTATUS_CONNECTING)
+        return;
+
+    NC_LOG_ERROR("[%s] Connecting to %s:%u timed out", _username.c_str(), _address.c_str(), (u32)_port);
+    Close(asio::error::timed_out);
+}
+
+void NovusConnection::SendCommand(ByteBuffer&& packet)
+{
+    PacketRecorder::Record(_botId, packet.GetReadPointer()[0], PACKETRECORD_OUTBOUND, packet.GetReadPointer(), static_cast<u32>(packet.GetActualSize()));
+    Send(std::move(packet));
+}
+
+void NovusConnection::Close(asio::error_code error)
+{
+    _status = NOVUSSTATUS_CLOSED;
+    BaseSocket::Close(error);
 }
 
 void NovusConnection::HandleRead()
@@ -81,38 +176,39 @@ void NovusConnection::HandleRead()
         return;
     }
 
-    ByteBuffer& byteBuffer = GetByteBuffer();
-    while (byteBuffer.GetActualSize())
+    RingBuffer& receiveBuffer = GetReceiveBuffer();
+    while (receiveBuffer.GetActualSize())
     {
-        u8 command = byteBuffer.GetDataPointer()[0];
+        u8 command = receiveBuffer.PeekAt<u8>(0);
 
-        auto itr = MessageHandlers.find(command);
-        if (itr == MessageHandlers.end())
+        NovusMessageHandler const* messageHandler = MessageHandlers.Find(command);
+        if (!messageHandler)
         {
-            byteBuffer.Clean();
+            receiveBuffer.Clean();
             break;
         }
 
         // Client attempted incorrect auth step
-        if (_status != itr->second.status)
+        if (_status != messageHandler->status)
         {
             Close(asio::error::shut_down);
             return;
         }
 
-        u16 size = u16(itr->second.packetSize);
-        if (byteBuffer.GetActualSize() < size)
+        u32 size = messageHandler->minSize;
+        if (receiveBuffer.GetActualSize() < size)
             break;
 
         if (command == NOVUS_CHALLENGE)
         {
-            if (byteBuffer.GetActualSize() == 3)
+            // A failed challenge is only the 3 byte header, decided by its result since a successful one can arrive in pieces
+            if (receiveBuffer.PeekAt<u8>(2) != AUTH_SUCCESS)
             {
                 // Challenge Failed
                 sAuthLogonChallengeHeader challengeHeader;
-                challengeHeader.Read(byteBuffer);
+                challengeHeader.Read(receiveBuffer);
 
-				PacketHooks::CallHook(PacketHooks::HOOK_ONLOGIN_CHALLENGE, _username, challengeHeader.result);
+				PacketHooks::CallHook<PacketHooks::HOOK_ONLOGIN_CHALLENGE>(_username, challengeHeader.result);
 
                 NC_LOG_ERROR("Login Failed: (%u, %u, %u)", (u32)challengeHeader.command, (u32)challengeHeader.error, (u32)challengeHeader.result);
 
@@ -124,11 +220,11 @@ void NovusConnection::HandleRead()
         }
         else if (command == NOVUS_PROOF)
         {
-            if (byteBuffer.GetActualSize() == 4)
+            if (receiveBuffer.PeekAt<u8>(1) != AUTH_SUCCESS)
             {
                 // Proof Failed
                 sAuthLogonProofHeader ProofHeader;
-                ProofHeader.Read(byteBuffer);
+                ProofHeader.Read(receiveBuffer);
 
                 NC_LOG_ERROR("Proof Failed: (%u, %u, %u)", (u32)ProofHeader.command, (u32)ProofHeader.error, (u32)ProofHeader.accountFlags);
 
@@ -137,17 +233,34 @@ void NovusConnection::HandleRead()
             }
             else
             {
-                size += 32;
+                size = sizeof(sAuthLogonProofData);
             }
         }
+        else if (command == NOVUS_REALM_LIST)
+        {
+            size += receiveBuffer.PeekAt<u16>(1);
+        }
 
-        if (!(*this.*itr->second.handler)())
+        // Wait for the rest of the packet
+        if (receiveBuffer.GetActualSize() < size)
+            break;
+
+        // Handlers parse the packet in place, so it has to be contiguous even if it wrapped around the end of the buffer
+        if (!receiveBuffer.Linearize(size))
+        {
+            Close(asio::error::message_size);
+            return;
+        }
+
+        PacketRecorder::Record(_botId, command, PACKETRECORD_INBOUND, receiveBuffer.GetReadPointer(), size);
+
+        if (!(*this.*messageHandler->handler)())
         {
             Close(asio::error::shut_down);
             return;
         }
 
-        byteBuffer.ReadBytes(size);
+        receiveBuffer.ReadBytes(size);
     }
 
     AsyncRead();
@@ -156,10 +269,13 @@ void NovusConnection::HandleRead()
 
 bool NovusConnection::HandleCommandChallenge()
 {
+    AuthTimings::Clock::time_point computeStart = AuthTimings::Clock::now();
+    AuthTimings::Record(AUTHTIMING_CHALLENGE_RTT, _stageStart, computeStart);
+
     _status = NOVUSSTATUS_PROOF;
-    sAuthLogonChallengeData* logonChallenge = reinterpret_cast<sAuthLogonChallengeData*>(GetByteBuffer().GetReadPointer());
+    sAuthLogonChallengeData* logonChallenge = reinterpret_cast<sAuthLogonChallengeData*>(GetReceiveBuffer().GetReadPointer());
     
-	PacketHooks::CallHook(PacketHooks::HOOK_ONLOGIN_CHALLENGE, _username, logonChallenge->result);
+	PacketHooks::CallHook<PacketHooks::HOOK_ONLOGIN_CHALLENGE>(_username, logonChallenge->result);
 
     BigNumber N, A, B, a, u, x, S, salt, version_challenge, g(logonChallenge->g), k(3);
     B.Bin2BN(logonChallenge->b, 32);
@@ -169,13 +285,16 @@ bool NovusConnection::HandleCommandChallenge()
 
     // Hash password
     SHA1Hasher shaPassword;
-    shaPassword.UpdateHashForBn(2, &salt, _passwordKey);
+    shaPassword.UpdateHashForBn(2, &salt, &_passwordKey);
     shaPassword.Finish();
     x.Bin2BN(shaPassword.GetData(), 20);
 
-    // Random Key Pair
-    a.Rand(19 * 8);
-    A = g.ModExponential(a, N);
+    // Random Key Pair, precomputed off the login path whenever the pool has one ready
+    if (!SRP6EphemeralPool::Acquire(logonChallenge->g, logonChallenge->n, a, A))
+    {
+        a.Rand(19 * 8);
+        A = g.ModExponential(a, N);
+    }
 
     if ((B % N).IsZero())
         return false;
@@ -214,7 +333,7 @@ bool NovusConnection::HandleCommandChallenge()
 
     for (i32 i = 0; i < 20; ++i)
         vK[i * 2 + 1] = sha.GetData()[i];
-    _key->Bin2BN(vK, 40);
+    _key.Bin2BN(vK, 40);
 
     // Generate Proof
     sha.Init();
@@ -242,7 +361,7 @@ bool NovusConnection::HandleCommandChallenge()
     sha.Init();
     sha.UpdateHashForBn(1, &t3);
     sha.UpdateHash(t4, SHA_DIGEST_LENGTH);
-    sha.UpdateHashForBn(4, &salt, &A, &B, _key);
+    sha.UpdateHashForBn(4, &salt, &A, &B, &_key);
     sha.Finish();
 
     BigNumber M;
@@ -264,22 +383,35 @@ bool NovusConnection::HandleCommandChallenge()
 
     // Finish SRP6
     sha.Init();
-    sha.UpdateHashForBn(3, &A, &M, _key);
+    sha.UpdateHashForBn(3, &A, &M, &_key);
     sha.Finish();
     memcpy(_proofM2, sha.GetData(), 20);
 
-    Send(packet);
+    _stageStart = AuthTimings::Clock::now();
+    AuthTimings::Record(AUTHTIMING_SRP_COMPUTE, computeStart, _stageStart);
+
+    SendCommand(std::move(packet));
     return true;
 }
 
 bool NovusConnection::HandleCommandProof()
 {
+    AuthTimings::Record(AUTHTIMING_PROOF_RTT, _stageStart, AuthTimings::Clock::now());
+
     _status = NOVUSSTATUS_AUTHED;
-    sAuthLogonProofData* logonProof = reinterpret_cast<sAuthLogonProofData*>(GetByteBuffer().GetReadPointer());
+    sAuthLogonProofData* logonProof = reinterpret_cast<sAuthLogonProofData*>(GetReceiveBuffer().GetReadPointer());
 
     if (!memcmp(_proofM2, logonProof->M2, 20))
     {
-        /* Send Realmlist here */
+        cAuthRealmList realmListRequest;
+        realmListRequest.command = NOVUS_REALM_LIST;
+        realmListRequest.unused = 0;
+
+        ByteBuffer packet(sizeof(cAuthRealmList));
+        packet.Append(reinterpret_cast<u8 const*>(&realmListRequest), sizeof(cAuthRealmList));
+
+        _stageStart = AuthTimings::Clock::now();
+        SendCommand(std::move(packet));
         return true;
     }
     else
@@ -287,4 +419,38 @@ bool NovusConnection::HandleCommandProof()
         NC_LOG_ERROR("Server sent invalid proof");
         return false;
     }
+}
+
+bool NovusConnection::HandleCommandRealmList()
+{
+    AuthTimings::Record(AUTHTIMING_REALMLIST_RTT, _stageStart, AuthTimings::Clock::now());
+
+    RingBuffer& receiveBuffer = GetReceiveBuffer();
+    u16 bodySize = receiveBuffer.PeekAt<u16>(1);
+
+    // The body is handed to the cache straight out of the receive buffer, it's only parsed when no bot has seen it yet
+    _realmList = RealmListCache::Get(receiveBuffer.GetReadPointer() + 3, bodySize);
+    if (!_realmList)
+    {
+        NC_LOG_ERROR("[%s] Server sent a malformed realm list", _username.c_str());
+        return false;
+    }
+
+    static const bool worldConnect = ConfigHandler::GetOption<bool>("worldConnect", true);
+    static const u32 worldReceiveBufferSize = ConfigHandler::GetOption<u32>("worldReceiveBufferSize", 16384);
+    if (!worldConnect || _realmList->realms.empty() || _worldConnection.load())
+        return true;
+
+    // Bots always pick the first realm
+    RealmInfo const& realm = _realmList->realms[0];
+    WorldConnection* worldConnection = new WorldConnection(new asio::ip::tcp::socket(_socket->get_executor().context()), _botId, _username, _key, worldReceiveBufferSize);
+    worldConnection->SetReplay(_replay, _replayStream);
+    _worldConnection = worldConnection;
+
+    if (!worldConnection->Start(realm.address, realm.port))
+    {
+        NC_LOG_ERROR("[%s] Failed to start world connection to %s:%u", _username.c_str(), realm.address.c_str(), (u32)realm.port);
+    }
+
+    return true;
 }
\ No newline at end of file
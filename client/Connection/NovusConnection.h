@@ -24,22 +24,28 @@
 #pragma once
 
 #include <asio\ip\tcp.hpp>
+#include <asio\steady_timer.hpp>
 #include "../Networking\BaseSocket.h"
+#include "../Networking\Opcode\OpcodeTable.h"
 #include "../Cryptography\BigNumber.h"
-#include "../Cryptography\StreamCrypto.h"
+#include "RealmList.h"
+#include "WorldConnection.h"
 #include <robin_hood.h>
+#include <atomic>
 
 enum NovusCommand
 {
     NOVUS_CHALLENGE         = 0x00,
-    NOVUS_PROOF             = 0x01
+    NOVUS_PROOF             = 0x01,
+    NOVUS_REALM_LIST        = 0x10
 };
 enum NovusStatus
 {
     NOVUSSTATUS_CHALLENGE   = 0,
     NOVUSSTATUS_PROOF       = 1,
     NOVUSSTATUS_AUTHED      = 2,
-    NOVUSSTATUS_CLOSED      = 3
+    NOVUSSTATUS_CLOSED      = 3,
+    NOVUSSTATUS_CONNECTING  = 4
 };
 enum AuthResult
 {
@@ -119,13 +125,19 @@ struct cAuthLogonProof
     u8 securityFlags;
 };
 
+struct cAuthRealmList
+{
+    u8  command;
+    u32 unused;
+};
+
 struct sAuthLogonChallengeHeader
 {
     u8  command;
     u8  error;
     u8  result;
 
-    void Read(ByteBuffer& buffer)
+    void Read(RingBuffer& buffer)
     {
         buffer.Read<u8>(command);
         buffer.Read<u8>(error);
@@ -154,7 +166,7 @@ struct sAuthLogonProofHeader
     u8  error;
     u16 accountFlags;
 
-    void Read(ByteBuffer& buffer)
+    void Read(RingBuffer& buffer)
     {
         buffer.Read<u8>(command);
         buffer.Read<u8>(error);
@@ -172,43 +184,66 @@ struct sAuthLogonProofData
     u16 LoginFlags;
 };
 
-class NovusConnection;
-struct NovusMessageHandler
-{
-    NovusStatus status;
-    size_t packetSize;
-    bool (NovusConnection::*handler)();
-};
 #pragma pack(pop)
 
+class NovusConnection;
+using NovusMessageHandler = OpcodeHandler<NovusStatus, bool (NovusConnection::*)()>;
+// Auth commands are a single byte
+using NovusMessageHandlerTable = OpcodeTable<NovusMessageHandler, 256>;
+
 class NovusConnection : public Common::BaseSocket
 {
 public:
-    static robin_hood::unordered_map<u8, NovusMessageHandler> InitMessageHandlers();
+    static constexpr NovusMessageHandlerTable InitMessageHandlers();
 
-    NovusConnection(asio::ip::tcp::socket* socket, std::string address, u16 port) : Common::BaseSocket(socket), _status(NOVUSSTATUS_CHALLENGE), _crypto(), _address(address), _port(port)
-    { 
-        _crypto = new StreamCrypto();
-        _key = new BigNumber();
-        _passwordKey = new BigNumber();
-    }
+    NovusConnection(asio::ip::tcp::socket* socket, std::string address, u16 port, u32 botId) : Common::BaseSocket(socket), _status(NOVUSSTATUS_CHALLENGE), _botId(botId), _address(address), _port(port), _connectTimer(), _stageStart(), _key(), _passwordKey(), _worldConnection(nullptr), _replay(nullptr), _replayStream(nullptr) { }
+    ~NovusConnection();
 
+    // Resolves the authserver and starts connecting asynchronously, the challenge is sent once the connection is established
     bool Start(std::string username, std::string password);
     void HandleRead() override;
+    void Close(asio::error_code error) override;
 
     bool HandleCommandChallenge();
     bool HandleCommandProof();
+    bool HandleCommandRealmList();
+
+    // Handed to the world connection once it's created, see WorldConnection::SetReplay
+    void SetReplay(ReplayCapture const* replay, ReplayStream const* stream) { _replay = replay; _replayStream = stream; }
+
+    std::shared_ptr<RealmList const> GetRealmList() const { return _realmList; }
+    // The world connection is started once the realm list arrived and is owned by this connection
+    WorldConnection* GetWorldConnection() const { return _worldConnection.load(); }
 
-    NovusStatus _status;
+    // Resolves through a process wide cache, every bot connects to the same few servers
+    static bool GetEndpoint(std::string const& address, u16 port, asio::ip::tcp::endpoint& endpoint);
+
+    std::atomic<NovusStatus> _status;
 private:
+    void HandleConnect(asio::error_code error);
+    void HandleConnectTimeout(asio::error_code error);
+
+    // Every outgoing auth command goes through here so the packet recorder sees it before it's queued
+    void SendCommand(ByteBuffer&& packet);
+
+private:
+    // Identifies the bot in packet captures, the index it was spawned with
+    u32 _botId;
     std::string _username;
-    std::string _password;
 
     std::string _address;
     u16 _port;
 
-    StreamCrypto* _crypto;
-    BigNumber* _key;
-    BigNumber* _passwordKey;
+    std::unique_ptr<asio::steady_timer> _connectTimer;
+    // When the stage currently being timed started, see AuthTimings
+    std::chrono::steady_clock::time_point _stageStart;
+    BigNumber _key;
+    BigNumber _passwordKey;
     u8 _proofM2[20];
+
+    std::shared_ptr<RealmList const> _realmList;
+    std::atomic<WorldConnection*> _worldConnection;
+
+    ReplayCapture const* _replay;
+    ReplayStream const* _replayStream;
 };
\ No newline at end of file
@@ -0,0 +1,163 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+
+#include "RealmList.h"
+#include "../Config/ConfigHandler.h"
+#include <cstdlib>
+
+std::mutex RealmListCache::_mutex;
+robin_hood::unordered_node_map<u32, RealmListCache::CacheEntry> RealmListCache::_entries;
+std::chrono::steady_clock::time_point RealmListCache::_nextPurge;
+std::atomic<u64> RealmListCache::_hits(0);
+std::atomic<u64> RealmListCache::_misses(0);
+
+bool RealmListReader::ReadHeader(u16& realmCount)
+{
+    u32 unused;
+    return Read(unused) && Read(realmCount);
+}
+
+bool RealmListReader::ReadRealm(RealmEntryView& realm)
+{
+    if (!Read(realm.type) || !Read(realm.locked) || !Read(realm.flags))
+        return false;
+
+    if (!ReadString(realm.name, realm.nameLength) || !ReadString(realm.address, realm.addressLength))
+        return false;
+
+    if (!Read(realm.population) || !Read(realm.characters) || !Read(realm.timezone) || !Read(realm.id))
+        return false;
+
+    realm.version[0] = realm.version[1] = realm.version[2] = 0;
+    realm.build = 0;
+    if (realm.flags & REALM_FLAG_SPECIFYBUILD)
+        return Read(realm.version[0]) && Read(realm.version[1]) && Read(realm.version[2]) && Read(realm.build);
+
+    return true;
+}
+
+bool RealmListReader::ReadString(char const*& string, size_t& length)
+{
+    u8 const* start = _data + _position;
+    u8 const* end = static_cast<u8 const*>(std::memchr(start, 0, _size - _position));
+    if (!end)
+        return false;
+
+    string = reinterpret_cast<char const*>(start);
+    length = end - start;
+    _position += length + 1;
+    return true;
+}
+
+std::shared_ptr<RealmList const> RealmListCache::Get(u8 const* body, size_t size)
+{
+    static const u32 timeToLive = ConfigHandler::GetOption<u32>("realmListCacheTTL", 60000);
+
+    // FNV-1a over the body, identical responses from the authserver hash to the same entry
+    u32 hash = 2166136261u;
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ body[i]) * 16777619u;
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto itr = _entries.find(hash);
+        if (itr != _entries.end() && itr->second.expiresAt > now && itr->second.body.size() == size && std::memcmp(itr->second.body.data(), body, size) == 0)
+        {
+            _hits++;
+            return itr->second.realmList;
+        }
+    }
+
+    _misses++;
+    std::shared_ptr<RealmList const> realmList = Parse(body, size);
+    if (!realmList)
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // Expired entries are only dropped once per time to live so inserting stays cheap
+    if (now >= _nextPurge)
+    {
+        for (auto entryItr = _entries.begin(); entryItr != _entries.end();)
+        {
+            if (entryItr->second.expiresAt <= now)
+                entryItr = _entries.erase(entryItr);
+            else
+                ++entryItr;
+        }
+
+        _nextPurge = now + std::chrono::milliseconds(timeToLive);
+    }
+
+    // A full cache means the bodies aren't repeating, the parsed list is still handed out, just not kept
+    if (_entries.size() >= MAX_ENTRIES && _entries.find(hash) == _entries.end())
+        return realmList;
+
+    CacheEntry& entry = _entries[hash];
+    entry.body.assign(body, body + size);
+    entry.realmList = realmList;
+    entry.expiresAt = now + std::chrono::milliseconds(timeToLive);
+
+    return realmList;
+}
+
+std::shared_ptr<RealmList const> RealmListCache::Parse(u8 const* body, size_t size)
+{
+    RealmListReader reader(body, size);
+
+    u16 realmCount;
+    if (!reader.ReadHeader(realmCount))
+        return nullptr;
+
+    std::shared_ptr<RealmList> realmList = std::make_shared<RealmList>();
+    realmList->realms.reserve(realmCount);
+
+    for (u16 i = 0; i < realmCount; i++)
+    {
+        RealmEntryView view;
+        if (!reader.ReadRealm(view))
+            return nullptr;
+
+        RealmInfo realm;
+        realm.type = view.type;
+        realm.flags = view.flags;
+        realm.id = view.id;
+        realm.population = view.population;
+        realm.name.assign(view.name, view.nameLength);
+
+        // The address is sent as host:port
+        std::string address(view.address, view.addressLength);
+        size_t separator = address.rfind(':');
+        if (separator == std::string::npos)
+            return nullptr;
+
+        realm.address = address.substr(0, separator);
+        realm.port = static_cast<u16>(std::strtoul(address.c_str() + separator + 1, nullptr, 10));
+
+        realmList->realms.push_back(std::move(realm));
+    }
+
+    return realmList;
+}
\ No newline at end of file
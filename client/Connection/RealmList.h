@@ -0,0 +1,139 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <robin_hood.h>
+#include "../NovusTypes.h"
+
+enum RealmFlags
+{
+    REALM_FLAG_NONE             = 0x00,
+    REALM_FLAG_VERSION_MISMATCH = 0x01,
+    REALM_FLAG_OFFLINE          = 0x02,
+    REALM_FLAG_SPECIFYBUILD     = 0x04,
+    REALM_FLAG_NEW              = 0x20,
+    REALM_FLAG_RECOMMENDED      = 0x40,
+    REALM_FLAG_FULL             = 0x80
+};
+
+// A realm entry as it sits in the receive buffer, name and address point into the packet and are not null terminated
+struct RealmEntryView
+{
+    u8 type;
+    u8 locked;
+    u8 flags;
+    char const* name;
+    size_t nameLength;
+    char const* address;
+    size_t addressLength;
+    f32 population;
+    u8 characters;
+    u8 timezone;
+    u8 id;
+    u8 version[3];
+    u16 build;
+};
+
+// Walks a REALM_LIST response body in place without copying it
+class RealmListReader
+{
+public:
+    RealmListReader(u8 const* data, size_t size) : _data(data), _size(size), _position(0) { }
+
+    bool ReadHeader(u16& realmCount);
+    bool ReadRealm(RealmEntryView& realm);
+
+private:
+    bool ReadString(char const*& string, size_t& length);
+
+    template <typename T>
+    bool Read(T& value)
+    {
+        if (_position + sizeof(T) > _size)
+            return false;
+
+        std::memcpy(&value, _data + _position, sizeof(T));
+        _position += sizeof(T);
+        return true;
+    }
+
+    u8 const* _data;
+    size_t _size;
+    size_t _position;
+};
+
+struct RealmInfo
+{
+    u8 type;
+    u8 flags;
+    u8 id;
+    f32 population;
+    std::string name;
+    std::string address;
+    u16 port;
+};
+
+struct RealmList
+{
+    std::vector<RealmInfo> realms;
+};
+
+// Every bot gets the same realm list, so the list is parsed once and shared until its TTL runs out
+class RealmListCache
+{
+public:
+    // Returns the cached list for an identical body, or parses it and caches the result. Returns nullptr for a malformed body
+    static std::shared_ptr<RealmList const> Get(u8 const* body, size_t size);
+
+    static u64 GetHits() { return _hits.load(); }
+    static u64 GetMisses() { return _misses.load(); }
+
+private:
+    RealmListCache() { }
+
+    static std::shared_ptr<RealmList const> Parse(u8 const* body, size_t size);
+
+    struct CacheEntry
+    {
+        std::vector<u8> body;
+        std::shared_ptr<RealmList const> realmList;
+        std::chrono::steady_clock::time_point expiresAt;
+    };
+
+    // Bodies differ per account, the cap keeps one entry per bot from piling up between purges
+    static constexpr size_t MAX_ENTRIES = 1024;
+
+    static std::mutex _mutex;
+    static robin_hood::unordered_node_map<u32, CacheEntry> _entries;
+    static std::chrono::steady_clock::time_point _nextPurge;
+    static std::atomic<u64> _hits;
+    static std::atomic<u64> _misses;
+};
\ No newline at end of file
@@ -0,0 +1,397 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+
+#include "WorldConnection.h"
+#include "NovusConnection.h"
+#include "AuthTimings.h"
+#include "../Networking/PacketRecorder.h"
+#include "../Scripting/PacketHooks.h"
+#include "../Scripting/Coroutines.h"
+#include "../Cryptography/SHA1.h"
+#include "../Config/ConfigHandler.h"
+#include "../Utils/DebugHandler.h"
+
+#pragma pack(push, 1)
+struct sAuthChallenge
+{
+    u32 unknown;
+    u32 serverSeed;
+    u8 seeds[32];
+};
+#pragma pack(pop)
+
+constexpr WorldMessageHandlerTable WorldConnection::InitMessageHandlers()
+{
+    WorldMessageHandlerTable messageHandlers;
+
+    messageHandlers.Register(Common::SMSG_AUTH_CHALLENGE, { &WorldConnection::HandleAuthChallenge, WORLDSTATUS_CHALLENGE,    sizeof(sAuthChallenge), OPCODE_DIRECTION_SERVER });
+    messageHandlers.Register(Common::SMSG_AUTH_RESPONSE,  { &WorldConnection::HandleAuthResponse,  WORLDSTATUS_AUTH_SESSION, 1,                      OPCODE_DIRECTION_SERVER });
+
+    return messageHandlers;
+}
+constexpr WorldMessageHandlerTable WorldMessageHandlers = WorldConnection::InitMessageHandlers();
+static_assert(WorldMessageHandlers.Accepts(OPCODE_DIRECTION_SERVER), "The world handler table may only contain opcodes the worldserver sends");
+
+WorldConnection::WorldConnection(asio::ip::tcp::socket* socket, u32 botId, std::string username, BigNumber const& sessionKey, size_t receiveBufferSize)
+    : Common::BaseSocket(socket, receiveBufferSize), _status(WORLDSTATUS_CONNECTING), _botId(botId), _username(username), _sessionKey(sessionKey), _crypto(), _address(), _port(0), _connectTimer(),
+    _stageStart(), _headerSize(4), _headerDecrypted(0), _hasHeader(false), _opcode(0), _bodySize(0), _largePacket(0), _isAssembling(false),
+    _replay(nullptr), _replayStream(nullptr), _replayIndex(0), _replayStart(), _replayTimer() { }
+
+bool WorldConnection::Start(std::string const& address, u16 port)
+{
+    static const u32 connectTimeout = ConfigHandler::GetOption<u32>("connectTimeout", 10000);
+
+    _address = address;
+    _port = port;
+
+    asio::ip::tcp::endpoint endpoint;
+    if (!NovusConnection::GetEndpoint(_address, _port, endpoint))
+        return false;
+
+    _connectTimer = std::make_unique<asio::steady_timer>(_socket->get_executor().context());
+    _connectTimer->expires_after(std::chrono::milliseconds(connectTimeout));
+    _connectTimer->async_wait(asio::bind_executor(_strand, std::bind(&WorldConnection::HandleConnectTimeout, this, std::placeholders::_1)));
+
+    _stageStart = AuthTimings::Clock::now();
+    _socket->async_connect(endpoint, asio::bind_executor(_strand, std::bind(&WorldConnection::HandleConnect, this, std::placeholders::_1)));
+    return true;
+}
+
+void WorldConnection::HandleConnect(asio::error_code error)
+{
+    if (_connectTimer)
+    {
+        _connectTimer->cancel();
+        _connectTimer.reset();
+    }
+
+    if (_status != WORLDSTATUS_CONNECTING)
+        return;
+
+    if (error)
+    {
+        NC_LOG_ERROR("[%s] Failed to connect to world %s:%u: %s", _username.c_str(), _address.c_str(), (u32)_port, error.message().c_str());
+        Close(error);
+        return;
+    }
+
+    AuthTimings::Clock::time_point now = AuthTimings::Clock::now();
+    AuthTimings::Record(AUTHTIMING_WORLD_CONNECT, _stageStart, now);
+    _stageStart = now;
+
+    // The worldserver speaks first with SMSG_AUTH_CHALLENGE
+    _status = WORLDSTATUS_CHALLENGE;
+    AsyncRead();
+}
+
+void WorldConnection::HandleConnectTimeout(asio::error_code error)
+{
+    if (error || _status != WORLDSTATUS_CONNECTING)
+        return;
+
+    NC_LOG_ERROR("[%s] Connecting to world %s:%u timed out", _username.c_str(), _address.c_str(), (u32)_port);
+    Close(asio::error::timed_out);
+}
+
+void WorldConnection::Close(asio::error_code error)
+{
+    if (_connectTimer)
+        _connectTimer->cancel();
+    if (_replayTimer)
+        _replayTimer->cancel();
+
+    if (_status == WORLDSTATUS_AUTHED)
+        CoroutineScheduler::PostStop(_botId);
+
+    _status = WORLDSTATUS_CLOSED;
+    BaseSocket::Close(error);
+}
+
+void WorldConnection::HandleRead()
+{
+    if (_status == WORLDSTATUS_CLOSED)
+        return;
+
+    RingBuffer& receiveBuffer = GetReceiveBuffer();
+    while (receiveBuffer.GetActualSize())
+    {
+        if (_isAssembling)
+        {
+            // Move whatever arrived over to the large packet, it's dispatched from there once complete
+            size_t copySize = std::min(receiveBuffer.GetActualSize(), static_cast<size_t>(_bodySize - _largePacket.GetActualSize()));
+            receiveBuffer.Read(_largePacket.GetWritePointer(), copySize);
+            _largePacket.WriteBytes(copySize);
+
+            if (_largePacket.GetActualSize() < _bodySize)
+                break;
+
+            _isAssembling = false;
+            bool result = DispatchPacket(_largePacket.GetReadPointer());
+            _largePacket.Clean();
+            ResetHeader();
+
+            if (!result)
+            {
+                Close(asio::error::shut_down);
+                return;
+            }
+            continue;
+        }
+
+        if (!_hasHeader && !ReadHeader())
+            break;
+
+        size_t packetSize = _headerSize + _bodySize;
+
+        // Packets that can never fit the receive buffer, or would wrap past its slack, are copied out instead of parsed in place
+        bool fitsInPlace = packetSize <= receiveBuffer.GetCapacity();
+        if (fitsInPlace && receiveBuffer.GetActualSize() < packetSize)
+            break;
+
+        if (!fitsInPlace || !receiveBuffer.Linearize(packetSize))
+        {
+            receiveBuffer.ReadBytes(_headerSize);
+            _largePacket.Clean();
+            _largePacket.Resize(_bodySize);
+            _isAssembling = true;
+            continue;
+        }
+
+        bool result = DispatchPacket(receiveBuffer.GetReadPointer() + _headerSize);
+        if (_status == WORLDSTATUS_CLOSED)
+            return;
+
+        receiveBuffer.ReadBytes(packetSize);
+        ResetHeader();
+
+        if (!result)
+        {
+            Close(asio::error::shut_down);
+            return;
+        }
+    }
+
+    AsyncRead();
+}
+
+bool WorldConnection::ReadHeader()
+{
+    RingBuffer& receiveBuffer = GetReceiveBuffer();
+
+    // The header is decrypted a byte at a time since the stream cipher can't go back, its size is only known after the first byte
+    while (_headerDecrypted < _headerSize && _headerDecrypted < receiveBuffer.GetActualSize())
+    {
+        _crypto.Decrypt(&receiveBuffer.At(_headerDecrypted), 1);
+        if (_headerDecrypted == 0)
+            _headerSize = (receiveBuffer.At(0) & 0x80) ? 5 : 4;
+
+        _headerDecrypted++;
+    }
+
+    if (_headerDecrypted < _headerSize)
+        return false;
+
+    // Size is big endian and includes the opcode, the opcode itself is little endian
+    u32 size;
+    if (_headerSize == 5)
+    {
+        size = (u32(receiveBuffer.At(0) & 0x7F) << 16) | (u32(receiveBuffer.At(1)) << 8) | receiveBuffer.At(2);
+        _opcode = u16(receiveBuffer.At(3) | (receiveBuffer.At(4) << 8));
+    }
+    else
+    {
+        size = (u32(receiveBuffer.At(0)) << 8) | receiveBuffer.At(1);
+        _opcode = u16(receiveBuffer.At(2) | (receiveBuffer.At(3) << 8));
+    }
+
+    _bodySize = size >= 2 ? size - 2 : 0;
+    _hasHeader = true;
+    return true;
+}
+
+void WorldConnection::ResetHeader()
+{
+    _headerSize = 4;
+    _headerDecrypted = 0;
+    _hasHeader = false;
+    _opcode = 0;
+    _bodySize = 0;
+}
+
+bool WorldConnection::DispatchPacket(u8* data)
+{
+    PacketRecorder::Record(_botId, _opcode, PACKETRECORD_INBOUND | PACKETRECORD_WORLD, data, _bodySize);
+
+    if (PacketHooks::HasOpcodeHooks(_opcode))
+    {
+        PacketView packet(_opcode, data, _bodySize);
+        PacketHooks::CallOpcodeHooks(_botId, packet);
+    }
+
+    if (CoroutineScheduler::IsWaitingFor(_opcode))
+        CoroutineScheduler::PostOpcode(_botId, _opcode);
+
+    WorldMessageHandler const* messageHandler = WorldMessageHandlers.Find(_opcode);
+
+    // Everything we don't handle yet is skipped
+    if (!messageHandler)
+        return true;
+
+    if (_status != messageHandler->status)
+        return false;
+
+    if (_bodySize < messageHandler->minSize)
+        return false;
+
+    return (*this.*messageHandler->handler)(data, _bodySize);
+}
+
+void WorldConnection::SendPacket(u16 opcode, u8 const* body, u32 size)
+{
+    // Client headers are always 6 bytes, a big endian size that includes the opcode followed by a 4 byte opcode
+    PacketRecorder::Record(_botId, opcode, PACKETRECORD_OUTBOUND | PACKETRECORD_WORLD, body, size);
+
+    u32 packetSize = size + 4;
+    u8 header[6];
+    header[0] = u8(packetSize >> 8);
+    header[1] = u8(packetSize);
+    header[2] = u8(opcode);
+    header[3] = u8(opcode >> 8);
+    header[4] = 0;
+    header[5] = 0;
+    _crypto.Encrypt(header, sizeof(header));
+
+    ByteBuffer packet(sizeof(header) + size);
+    packet.Append(header, sizeof(header));
+    if (size)
+        packet.Append(body, size);
+
+    Send(std::move(packet));
+}
+
+bool WorldConnection::HandleAuthChallenge(u8* data, u32 size)
+{
+    sAuthChallenge* authChallenge = reinterpret_cast<sAuthChallenge*>(data);
+
+    u32 clientSeed = static_cast<u32>(rand()) ^ (static_cast<u32>(rand()) << 16);
+    u32 zero = 0;
+
+    SHA1Hasher sha;
+    sha.UpdateHash(_username);
+    sha.UpdateHash(reinterpret_cast<u8 const*>(&zero), 4);
+    sha.UpdateHash(reinterpret_cast<u8 const*>(&clientSeed), 4);
+    sha.UpdateHash(reinterpret_cast<u8 const*>(&authChallenge->serverSeed), 4);
+    sha.UpdateHashForBn(1, &_sessionKey);
+    sha.Finish();
+
+    ByteBuffer authSession(128);
+    authSession.Write<u32>(12340); // Build
+    authSession.Write<u32>(0); // Login server id
+    authSession.WriteString(_username);
+    authSession.Write<u32>(0); // Login server type
+    authSession.Write<u32>(clientSeed);
+    authSession.Write<u32>(0); // Region id
+    authSession.Write<u32>(0); // Battlegroup id
+    authSession.Write<u32>(1); // Realm id
+    authSession.Write<u64>(3); // Dos response
+    authSession.Append(sha.GetData(), 20);
+    authSession.Write<u32>(0); // No addon info
+
+    // CMSG_AUTH_SESSION is the last packet that goes out in plain text
+    SendPacket(Common::CMSG_AUTH_SESSION, authSession.GetReadPointer(), authSession.GetActualSize());
+    _crypto.SetupClient(&_sessionKey);
+
+    _status = WORLDSTATUS_AUTH_SESSION;
+    _stageStart = AuthTimings::Clock::now();
+    _replayStart = _stageStart;
+    return true;
+}
+
+bool WorldConnection::HandleAuthResponse(u8* data, u32 size)
+{
+    AuthTimings::Record(AUTHTIMING_WORLD_AUTH_RTT, _stageStart, AuthTimings::Clock::now());
+
+    u8 result = data[0];
+    if (result != WORLD_AUTH_OK && result != WORLD_AUTH_WAIT_QUEUE)
+    {
+        NC_LOG_ERROR("[%s] World authentication failed: %u", _username.c_str(), (u32)result);
+        return false;
+    }
+
+    _status = WORLDSTATUS_AUTHED;
+    CoroutineScheduler::PostStart(_botId);
+
+    if (_replayStream && !_replayStream->packets.empty())
+    {
+        _replayTimer = std::make_unique<asio::steady_timer>(_socket->get_executor().context());
+        SendReplayPackets();
+    }
+
+    return true;
+}
+
+void WorldConnection::SendReplayPackets()
+{
+    // Even when replaying as fast as possible a bot yields its strand every so often so its reads aren't starved
+    constexpr u32 MAX_REPLAY_BURST = 64;
+
+    std::vector<ReplayPacket> const& packets = _replayStream->packets;
+    f64 timeScale = _replay->GetTimeScale();
+    u64 elapsed = static_cast<u64>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _replayStart).count());
+
+    for (u32 sent = 0; _replayIndex < packets.size(); sent++)
+    {
+        ReplayPacket const& packet = packets[_replayIndex];
+
+        if (sent == MAX_REPLAY_BURST)
+        {
+            _replayTimer->expires_after(std::chrono::microseconds(0));
+            _replayTimer->async_wait(asio::bind_executor(_strand, std::bind(&WorldConnection::HandleReplayTimer, this, std::placeholders::_1)));
+            return;
+        }
+
+        if (timeScale > 0.0)
+        {
+            u64 due = static_cast<u64>(packet.delay / timeScale);
+            if (due > elapsed)
+            {
+                _replayTimer->expires_at(_replayStart + std::chrono::microseconds(due));
+                _replayTimer->async_wait(asio::bind_executor(_strand, std::bind(&WorldConnection::HandleReplayTimer, this, std::placeholders::_1)));
+                return;
+            }
+        }
+
+        SendPacket(packet.opcode, _replay->GetPayload(packet), packet.size);
+        _replay->OnPacketSent();
+        _replayIndex++;
+    }
+}
+
+void WorldConnection::HandleReplayTimer(asio::error_code error)
+{
+    if (error || _status != WORLDSTATUS_AUTHED)
+        return;
+
+    SendReplayPackets();
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include <asio\ip\tcp.hpp>
+#include <asio\steady_timer.hpp>
+#include "../Networking\BaseSocket.h"
+#include "../Networking\Opcode\Opcode.h"
+#include "../Networking\Opcode\OpcodeTable.h"
+#include "../Cryptography\BigNumber.h"
+#include "../Cryptography\StreamCrypto.h"
+#include "../Swarm\ReplayCapture.h"
+#include <atomic>
+#include <chrono>
+
+enum WorldStatus
+{
+    WORLDSTATUS_CONNECTING      = 0,
+    WORLDSTATUS_CHALLENGE       = 1,
+    WORLDSTATUS_AUTH_SESSION    = 2,
+    WORLDSTATUS_AUTHED          = 3,
+    WORLDSTATUS_CLOSED          = 4
+};
+
+enum WorldAuthResult
+{
+    WORLD_AUTH_OK               = 0x0C,
+    WORLD_AUTH_WAIT_QUEUE       = 0x1B
+};
+
+class WorldConnection;
+using WorldMessageHandler = OpcodeHandler<WorldStatus, bool (WorldConnection::*)(u8* data, u32 size)>;
+using WorldMessageHandlerTable = OpcodeTable<WorldMessageHandler, Common::NUM_MSG_TYPES>;
+
+// Connection to the worldserver of a realm, authenticated with the session key the authserver handed out
+class WorldConnection : public Common::BaseSocket
+{
+public:
+    static constexpr WorldMessageHandlerTable InitMessageHandlers();
+
+    WorldConnection(asio::ip::tcp::socket* socket, u32 botId, std::string username, BigNumber const& sessionKey, size_t receiveBufferSize);
+
+    // Sends the stream's packets once authed, with the captured timing scaled by the replay's time scale
+    void SetReplay(ReplayCapture const* replay, ReplayStream const* stream) { _replay = replay; _replayStream = stream; }
+
+    bool Start(std::string const& address, u16 port);
+    void HandleRead() override;
+    void Close(asio::error_code error) override;
+
+    // Has to be called on the connection's strand, the header is encrypted when the packet is queued so the stream cipher sees packets in send order
+    void SendPacket(u16 opcode, u8 const* body, u32 size);
+
+    bool HandleAuthChallenge(u8* data, u32 size);
+    bool HandleAuthResponse(u8* data, u32 size);
+
+    std::atomic<WorldStatus> _status;
+private:
+    void HandleConnect(asio::error_code error);
+    void HandleConnectTimeout(asio::error_code error);
+
+    // Decrypts header bytes in place as they arrive, returns false until the whole header is available
+    bool ReadHeader();
+    bool DispatchPacket(u8* data);
+    void ResetHeader();
+
+    void SendReplayPackets();
+    void HandleReplayTimer(asio::error_code error);
+
+private:
+    u32 _botId;
+    std::string _username;
+    BigNumber _sessionKey;
+    StreamCrypto _crypto;
+
+    std::string _address;
+    u16 _port;
+    std::unique_ptr<asio::steady_timer> _connectTimer;
+    std::chrono::steady_clock::time_point _stageStart;
+
+    // State of the packet currently being received, the server header is 4 bytes or 5 for packets of 32 KB and more
+    u32 _headerSize;
+    u32 _headerDecrypted;
+    bool _hasHeader;
+    u16 _opcode;
+    u32 _bodySize;
+
+    // Packets that don't fit into the receive buffer are assembled here
+    ByteBuffer _largePacket;
+    bool _isAssembling;
+
+    ReplayCapture const* _replay;
+    ReplayStream const* _replayStream;
+    size_t _replayIndex;
+    // Replay delays are measured from when CMSG_AUTH_SESSION was sent, the same point they're relative to in the capture
+    std::chrono::steady_clock::time_point _replayStart;
+    std::unique_ptr<asio::steady_timer> _replayTimer;
+};
\ No newline at end of file
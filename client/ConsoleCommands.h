@@ -12,6 +12,9 @@
 #include "ConsoleCommands/QuitCommand.h"
 #include "ConsoleCommands/PingCommand.h"
 #include "ConsoleCommands/ReloadCommand.h"
+#include "ConsoleCommands/SwarmCommand.h"
+#include "ConsoleCommands/StatsCommand.h"
+#include "ConsoleCommands/ProfileCommand.h"
 
 class ConsoleCommandHandler
 {
@@ -21,6 +24,9 @@ public:
 		RegisterCommand("quit"_h, &QuitCommand);
 		RegisterCommand("ping"_h, &PingCommand);
 		RegisterCommand("reload"_h, &ReloadCommand);
+		RegisterCommand("swarm"_h, &SwarmCommand);
+		RegisterCommand("stats"_h, &StatsCommand);
+		RegisterCommand("profile"_h, &ProfileCommand);
 	}
 
 	void HandleCommand(ClientHandler& clientHandler, std::string& command)
@@ -28,6 +28,9 @@
 
 void ReloadCommand(ClientHandler& clientHandler, std::vector<std::string> subCommands)
 {
+	if (subCommands.empty())
+		return;
+
 	u32 hashedSubCommand = StringUtils::fnv1a_32(subCommands[0].c_str(), subCommands[0].size());
 	if (hashedSubCommand == "script"_h || hashedSubCommand == "scripts"_h)
 	{
@@ -27,8 +27,62 @@
 #include <cstring>
 #include <algorithm>
 #include <memory>
+#include <vector>
 #include "../NovusTypes.h"
 
+// Every thread keeps its own scratch context and Montgomery parameters, so the math never has to lock or allocate once warmed up
+struct BigNumberThreadContext
+{
+    // The SRP6 modulus doesn't change between logins, a handful of entries is plenty
+    static constexpr size_t MAX_MONTGOMERY_CONTEXTS = 8;
+
+    BigNumberThreadContext() : context(BN_CTX_new()) { }
+    ~BigNumberThreadContext()
+    {
+        for (auto& entry : montgomeryContexts)
+        {
+            BN_free(entry.first);
+            BN_MONT_CTX_free(entry.second);
+        }
+        BN_CTX_free(context);
+    }
+
+    BN_MONT_CTX* GetMontgomeryContext(BIGNUM const* modulus)
+    {
+        for (auto& entry : montgomeryContexts)
+        {
+            if (BN_cmp(entry.first, modulus) == 0)
+                return entry.second;
+        }
+
+        BN_MONT_CTX* montgomeryContext = BN_MONT_CTX_new();
+        if (!BN_MONT_CTX_set(montgomeryContext, modulus, context))
+        {
+            BN_MONT_CTX_free(montgomeryContext);
+            return nullptr;
+        }
+
+        if (montgomeryContexts.size() >= MAX_MONTGOMERY_CONTEXTS)
+        {
+            BN_free(montgomeryContexts.front().first);
+            BN_MONT_CTX_free(montgomeryContexts.front().second);
+            montgomeryContexts.erase(montgomeryContexts.begin());
+        }
+
+        montgomeryContexts.emplace_back(BN_dup(modulus), montgomeryContext);
+        return montgomeryContext;
+    }
+
+    BN_CTX* context;
+    std::vector<std::pair<BIGNUM*, BN_MONT_CTX*>> montgomeryContexts;
+};
+
+static BigNumberThreadContext& GetThreadContext()
+{
+    thread_local BigNumberThreadContext threadContext;
+    return threadContext;
+}
+
 BigNumber::BigNumber() : _bigNum(BN_new()) { }
 
 BigNumber::BigNumber(BigNumber const& bigNum) : _bigNum(BN_dup(bigNum._bigNum)) { }
@@ -113,22 +167,21 @@ void BigNumber::Rand(size_t bits)
 BigNumber BigNumber::Exponential(BigNumber const& bigNum)
 {
     BigNumber ret;
-    BN_CTX *bigNumContext;
-
-    bigNumContext = BN_CTX_new();
-    BN_exp(ret._bigNum, _bigNum, bigNum._bigNum, bigNumContext);
-    BN_CTX_free(bigNumContext);
+    BN_exp(ret._bigNum, _bigNum, bigNum._bigNum, GetThreadContext().context);
 
     return ret;
 }
 BigNumber BigNumber::ModExponential(BigNumber const& bn1, BigNumber const& bn2)
 {
     BigNumber ret;
-    BN_CTX *bigNumContext;
+    BigNumberThreadContext& threadContext = GetThreadContext();
 
-    bigNumContext = BN_CTX_new();
-    BN_mod_exp(ret._bigNum, _bigNum, bn1._bigNum, bn2._bigNum, bigNumContext);
-    BN_CTX_free(bigNumContext);
+    // Montgomery multiplication only works for odd moduli
+    BN_MONT_CTX* montgomeryContext = BN_is_odd(bn2._bigNum) ? threadContext.GetMontgomeryContext(bn2._bigNum) : nullptr;
+    if (montgomeryContext)
+        BN_mod_exp_mont(ret._bigNum, _bigNum, bn1._bigNum, bn2._bigNum, threadContext.context, montgomeryContext);
+    else
+        BN_mod_exp(ret._bigNum, _bigNum, bn1._bigNum, bn2._bigNum, threadContext.context);
 
     return ret;
 }
@@ -166,31 +219,19 @@ BigNumber BigNumber::operator-=(BigNumber const& bigNum)
 }
 BigNumber BigNumber::operator*=(BigNumber const& bigNum)
 {
-    BN_CTX *bigNumContext;
-
-    bigNumContext = BN_CTX_new();
-    BN_mul(_bigNum, _bigNum, bigNum._bigNum, bigNumContext);
-    BN_CTX_free(bigNumContext);
+    BN_mul(_bigNum, _bigNum, bigNum._bigNum, GetThreadContext().context);
 
     return *this;
 }
 BigNumber BigNumber::operator/=(BigNumber const& bigNum)
 {
-    BN_CTX *bigNumContext;
-
-    bigNumContext = BN_CTX_new();
-    BN_div(_bigNum, nullptr, _bigNum, bigNum._bigNum, bigNumContext);
-    BN_CTX_free(bigNumContext);
+    BN_div(_bigNum, nullptr, _bigNum, bigNum._bigNum, GetThreadContext().context);
 
     return *this;
 }
 BigNumber BigNumber::operator%=(BigNumber const& bigNum)
 {
-    BN_CTX *bigNumContext;
-
-    bigNumContext = BN_CTX_new();
-    BN_mod(_bigNum, _bigNum, bigNum._bigNum, bigNumContext);
-    BN_CTX_free(bigNumContext);
+    BN_mod(_bigNum, _bigNum, bigNum._bigNum, GetThreadContext().context);
 
     return *this;
 }
@@ -0,0 +1,154 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+
+#include "SRP6EphemeralPool.h"
+#include "BigNumber.h"
+#include "../Config/ConfigHandler.h"
+#include "../Utils/DebugHandler.h"
+#include <algorithm>
+#include <cstring>
+
+asio::io_service* SRP6EphemeralPool::_ioService = nullptr;
+u32 SRP6EphemeralPool::_capacity = 0;
+u32 SRP6EphemeralPool::_lowWatermark = 0;
+u32 SRP6EphemeralPool::_batchSize = 0;
+
+std::mutex SRP6EphemeralPool::_parameterMutex;
+std::atomic<SRP6Parameters const*> SRP6EphemeralPool::_parameters(nullptr);
+std::vector<std::unique_ptr<SRP6Parameters>> SRP6EphemeralPool::_publishedParameters;
+
+moodycamel::ConcurrentQueue<SRP6Ephemeral> SRP6EphemeralPool::_ephemerals;
+std::atomic<bool> SRP6EphemeralPool::_isRefilling(false);
+std::atomic<u64> SRP6EphemeralPool::_hits(0);
+std::atomic<u64> SRP6EphemeralPool::_misses(0);
+
+void SRP6EphemeralPool::Start(asio::io_service* ioService)
+{
+    _ioService = ioService;
+    _capacity = ConfigHandler::GetOption<u32>("ephemeralPoolSize", 256);
+    _batchSize = std::max(ConfigHandler::GetOption<u32>("ephemeralPoolBatch", 16), 1u);
+    _lowWatermark = _capacity / 2;
+
+    if (_capacity > 0)
+    {
+        NC_LOG_MESSAGE("SRP6: Precomputing up to %u client ephemerals", _capacity);
+    }
+}
+
+bool SRP6EphemeralPool::Acquire(u8 g, u8 const* N, BigNumber& a, BigNumber& A)
+{
+    if (_capacity == 0)
+        return false;
+
+    // Nothing can be precomputed until the first challenge told us g and N
+    SRP6Parameters const* parameters = _parameters.load(std::memory_order_acquire);
+    if (!parameters || parameters->g != g || std::memcmp(parameters->N, N, sizeof(parameters->N)) != 0)
+        parameters = Publish(g, N);
+
+    u32 generation = parameters->generation;
+
+    SRP6Ephemeral ephemeral;
+    bool found = false;
+    while (_ephemerals.try_dequeue(ephemeral))
+    {
+        // Pairs computed for an older g/N are simply dropped
+        if (ephemeral.generation == generation)
+        {
+            found = true;
+            break;
+        }
+    }
+
+    if (_ephemerals.size_approx() < _lowWatermark)
+        ScheduleRefill();
+
+    if (!found)
+    {
+        _misses++;
+        return false;
+    }
+
+    a.Bin2BN(ephemeral.a, sizeof(ephemeral.a));
+    A.Bin2BN(ephemeral.A, sizeof(ephemeral.A));
+    _hits++;
+    return true;
+}
+
+SRP6Parameters const* SRP6EphemeralPool::Publish(u8 g, u8 const* N)
+{
+    std::lock_guard<std::mutex> lock(_parameterMutex);
+
+    // Every login that raced on the first challenge ends up here, only the first one publishes
+    SRP6Parameters const* current = _parameters.load(std::memory_order_relaxed);
+    if (current && current->g == g && std::memcmp(current->N, N, sizeof(current->N)) == 0)
+        return current;
+
+    std::unique_ptr<SRP6Parameters> parameters = std::make_unique<SRP6Parameters>();
+    parameters->generation = current ? current->generation + 1 : 1;
+    parameters->g = g;
+    std::memcpy(parameters->N, N, sizeof(parameters->N));
+
+    _parameters.store(parameters.get(), std::memory_order_release);
+    _publishedParameters.push_back(std::move(parameters));
+    return _publishedParameters.back().get();
+}
+
+void SRP6EphemeralPool::ScheduleRefill()
+{
+    if (!_ioService || _isRefilling.exchange(true))
+        return;
+
+    asio::post(*_ioService, &SRP6EphemeralPool::Refill);
+}
+
+void SRP6EphemeralPool::Refill()
+{
+    // Only scheduled after the first challenge published parameters
+    SRP6Parameters const* parameters = _parameters.load(std::memory_order_acquire);
+    BigNumber g, N;
+    g.SetUInt32(parameters->g);
+    N.Bin2BN(parameters->N, sizeof(parameters->N));
+
+    for (u32 i = 0; i < _batchSize && _ephemerals.size_approx() < _capacity; i++)
+    {
+        BigNumber a;
+        a.Rand(19 * 8);
+        BigNumber A = g.ModExponential(a, N);
+
+        SRP6Ephemeral ephemeral;
+        ephemeral.generation = parameters->generation;
+        std::memcpy(ephemeral.a, a.BN2BinArray(sizeof(ephemeral.a)).get(), sizeof(ephemeral.a));
+        std::memcpy(ephemeral.A, A.BN2BinArray(sizeof(ephemeral.A)).get(), sizeof(ephemeral.A));
+        _ephemerals.enqueue(ephemeral);
+    }
+
+    // Refilling one batch per handler keeps the io threads free for the connections in between
+    if (_ephemerals.size_approx() < _capacity && parameters == _parameters.load(std::memory_order_acquire))
+    {
+        asio::post(*_ioService, &SRP6EphemeralPool::Refill);
+        return;
+    }
+
+    _isRefilling = false;
+}
\ No newline at end of file
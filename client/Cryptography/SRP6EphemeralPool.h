@@ -0,0 +1,87 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <asio.hpp>
+#include "../NovusTypes.h"
+#include "../Utils/ConcurrentQueue.h"
+
+class BigNumber;
+
+// A precomputed client ephemeral, both values are stored little endian like they go over the wire
+struct SRP6Ephemeral
+{
+    u32 generation;
+    u8 a[19];
+    u8 A[32];
+};
+
+// The g/N a generation of ephemerals was computed for, never changed once published
+struct SRP6Parameters
+{
+    u32 generation;
+    u8 g;
+    u8 N[32];
+};
+
+// Keeps a pool of ready (a, A) pairs for the g/N the authserver sent last, refilled in batches on the io threads
+class SRP6EphemeralPool
+{
+public:
+    static void Start(asio::io_service* ioService);
+
+    // Returns false when the pool is empty or g/N changed, the caller has to compute the pair inline then
+    static bool Acquire(u8 g, u8 const* N, BigNumber& a, BigNumber& A);
+
+    static u64 GetHits() { return _hits.load(); }
+    static u64 GetMisses() { return _misses.load(); }
+    static size_t GetAvailable() { return _ephemerals.size_approx(); }
+
+private:
+    SRP6EphemeralPool() { }
+
+    static SRP6Parameters const* Publish(u8 g, u8 const* N);
+    static void ScheduleRefill();
+    static void Refill();
+
+    static asio::io_service* _ioService;
+    static u32 _capacity;
+    static u32 _lowWatermark;
+    static u32 _batchSize;
+
+    // Logins compare against the published parameters without locking, the mutex only serializes publishing new ones.
+    // Replaced parameters are kept alive since a login may still be reading them, g/N hardly ever change in a run.
+    static std::mutex _parameterMutex;
+    static std::atomic<SRP6Parameters const*> _parameters;
+    static std::vector<std::unique_ptr<SRP6Parameters>> _publishedParameters;
+
+    static moodycamel::ConcurrentQueue<SRP6Ephemeral> _ephemerals;
+    static std::atomic<bool> _isRefilling;
+    static std::atomic<u64> _hits;
+    static std::atomic<u64> _misses;
+};
\ No newline at end of file
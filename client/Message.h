@@ -22,16 +22,50 @@
     SOFTWARE.
 */
 #pragma once
-#include <string>
-#include "Networking/ByteBuffer.h"
+#include <cstring>
+#include "NovusTypes.h"
+#include "Networking/PacketPool.h"
 
+// Kept trivially copyable and cache line sized so the message queues never allocate, larger payloads are stored in a pooled ByteBuffer
 struct Message
 {
-    Message() { code = -1; opcode = -1; account = -1; message = nullptr; }
+    static constexpr size_t INLINE_PAYLOAD_SIZE = 40;
+
+    Message() { code = -1; opcode = -1; account = -1; payloadSize = 0; packet = nullptr; }
+
+    void SetText(char const* text, size_t length)
+    {
+        if (length < INLINE_PAYLOAD_SIZE)
+        {
+            std::memcpy(payload, text, length);
+            payload[length] = 0;
+        }
+        else
+        {
+            packet = PacketPool::Acquire();
+            packet->Append(reinterpret_cast<u8 const*>(text), length);
+            packet->Write<u8>(0);
+        }
+        payloadSize = static_cast<u16>(length);
+    }
+    char const* GetText() const { return packet ? reinterpret_cast<char const*>(packet->data()) : reinterpret_cast<char const*>(payload); }
+
+    // The consumer of a message has to release it so its pooled packet goes back to the pool
+    void Release()
+    {
+        if (packet)
+        {
+            PacketPool::Release(packet);
+            packet = nullptr;
+        }
+        payloadSize = 0;
+    }
 
     i32 code;
     i16 opcode;
+    u16 payloadSize;
     i32 account;
-    ByteBuffer packet;
-	std::string* message;
-};
\ No newline at end of file
+    ByteBuffer* packet;
+    u8 payload[INLINE_PAYLOAD_SIZE];
+};
+static_assert(sizeof(Message) == 64, "Message should stay cache line sized");
\ No newline at end of file
@@ -29,14 +29,32 @@
 #include <functional>
 #include <asio.hpp>
 #include <asio\placeholders.hpp>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <vector>
 #include "ByteBuffer.h"
+#include "RingBuffer.h"
+#include "../Utils/DebugHandler.h"
 
 namespace Common
 {
     class BaseSocket : public std::enable_shared_from_this<BaseSocket>
     {
     public:
-        virtual void Close(asio::error_code error) { _socket->close(); _isClosed = true; std::cout << "Closed: " << error.message().c_str() << std::endl; }
+        virtual ~BaseSocket() { delete _socket; }
+
+        virtual void Close(asio::error_code error)
+        {
+            _socket->close();
+            _isClosed = true;
+
+            // Swarm shutdowns close every connection and abort its pending read, only other errors are worth a line
+            if (error != asio::error::shut_down && error != asio::error::operation_aborted)
+            {
+                NC_LOG_WARNING("Closed: %s", error.message().c_str());
+            }
+        }
         virtual void HandleRead() = 0;
 
         asio::ip::tcp::socket* socket()
@@ -44,20 +62,29 @@ namespace Common
             return _socket;
         }
 
-        void Send(ByteBuffer& buffer)
+        // All handlers of a connection run through its strand, post to it when touching the socket from another thread
+        asio::io_service::strand& GetStrand() { return _strand; }
+
+        // Takes ownership of the packet, everything queued before the strand gets to flush is written with a single gathered write
+        void Send(ByteBuffer&& buffer)
         {
-            if (!buffer.empty())
+            if (buffer.empty())
+                return;
+
             {
-                _socket->async_write_some(asio::buffer(buffer.GetReadPointer(), buffer.GetActualSize()),
-                   std::bind(&BaseSocket::HandleInternalWrite, this, std::placeholders::_1, std::placeholders::_2));
+                std::lock_guard<std::mutex> lock(_sendQueueMutex);
+                _sendQueue.push_back(std::move(buffer));
             }
+            _sendQueueDepth++;
+
+            if (!_isFlushScheduled.exchange(true))
+                asio::post(_strand, std::bind(&BaseSocket::FlushSendQueue, this));
         }
+        // Packets queued or in flight that have not been fully written yet
+        size_t GetSendQueueDepth() const { return _sendQueueDepth.load(); }
         bool IsClosed() { return _isClosed; }
     protected:
-        BaseSocket(asio::ip::tcp::socket* socket) : _socket(socket), _byteBuffer(), _isClosed(false)
-        { 
-            _byteBuffer.Resize(4096);
-        }
+        BaseSocket(asio::ip::tcp::socket* socket, size_t receiveBufferSize = 4096, size_t receiveBufferSlack = 1024) : _socket(socket), _strand(socket->get_executor().context()), _receiveBuffer(receiveBufferSize, receiveBufferSlack), _isClosed(false), _isWriting(false), _isFlushScheduled(false), _sendQueueDepth(0) { }
 
         void AsyncRead()
         {
@@ -65,11 +92,23 @@ namespace Common
             if (!_socket->is_open())
                 return;
 
-            _byteBuffer.CleanBuffer();
-            _byteBuffer.RecalculateSize();
+            // A full buffer means a single packet is larger than what this connection was set up to receive
+            if (_receiveBuffer.GetSpaceLeft() == 0)
+            {
+                Close(asio::error::no_buffer_space);
+                return;
+            }
+
+            std::array<asio::mutable_buffer, 2> buffers;
+            u8* first;
+            u8* second;
+            size_t firstSize, secondSize;
+            _receiveBuffer.GetWriteRegions(first, firstSize, second, secondSize);
+            buffers[0] = asio::buffer(first, firstSize);
+            buffers[1] = asio::buffer(second, secondSize);
 
-            _socket->async_read_some(asio::buffer(_byteBuffer.GetWritePointer(), _byteBuffer.GetSpaceLeft()),
-                std::bind(&BaseSocket::HandleInternalRead, this, std::placeholders::_1, std::placeholders::_2));
+            _socket->async_read_some(buffers,
+                asio::bind_executor(_strand, std::bind(&BaseSocket::HandleInternalRead, this, std::placeholders::_1, std::placeholders::_2)));
         }
         void HandleInternalRead(asio::error_code error, size_t bytes)
         {
@@ -80,21 +119,62 @@ namespace Common
                 return;
             }
 
-            _byteBuffer.WriteBytes(bytes);
+            _receiveBuffer.WriteBytes(bytes);
             HandleRead();
         }        
+        void FlushSendQueue()
+        {
+            _isFlushScheduled = false;
+
+            // The completion of the write in flight picks up whatever got queued meanwhile
+            if (_isWriting || _isClosed)
+                return;
+
+            {
+                std::lock_guard<std::mutex> lock(_sendQueueMutex);
+                if (_sendQueue.empty())
+                    return;
+
+                _sendQueue.swap(_writeQueue);
+            }
+
+            _writeBuffers.clear();
+            for (ByteBuffer& packet : _writeQueue)
+                _writeBuffers.push_back(asio::buffer(packet.GetReadPointer(), packet.GetActualSize()));
+
+            _isWriting = true;
+            asio::async_write(*_socket, _writeBuffers,
+                asio::bind_executor(_strand, std::bind(&BaseSocket::HandleInternalWrite, this, std::placeholders::_1, std::placeholders::_2)));
+        }
         void HandleInternalWrite(asio::error_code error, std::size_t transferedBytes)
         {
+            _isWriting = false;
+            _sendQueueDepth -= _writeQueue.size();
+            _writeQueue.clear();
+
             if (error)
             {
                 Close(error);
+                return;
             }
+
+            FlushSendQueue();
         }
 
-        ByteBuffer& GetByteBuffer() { return _byteBuffer; }
-        ByteBuffer _byteBuffer;
+        RingBuffer& GetReceiveBuffer() { return _receiveBuffer; }
+        RingBuffer _receiveBuffer;
 
         bool _isClosed;
         asio::ip::tcp::socket* _socket;
+        asio::io_service::strand _strand;
+
+        // _sendQueue is filled from any thread, _writeQueue and _writeBuffers are only touched on the strand
+        std::mutex _sendQueueMutex;
+        std::vector<ByteBuffer> _sendQueue;
+        std::vector<ByteBuffer> _writeQueue;
+        std::vector<asio::const_buffer> _writeBuffers;
+        bool _isWriting;
+        std::atomic<bool> _isFlushScheduled;
+        std::atomic<size_t> _sendQueueDepth;
     };
 }
\ No newline at end of file
@@ -0,0 +1,225 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#include "BufferPool.h"
+#include "../Utils/ConcurrentQueue.h"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// Blocks a thread keeps per size class before handing a batch back to the global freelist
+constexpr u32 THREAD_CACHE_CAPACITY = 64;
+constexpr u32 TRANSFER_BATCH_SIZE = 32;
+// Upper bound on the memory kept in each global freelist, whatever is released beyond it goes back to the heap
+constexpr size_t GLOBAL_CLASS_BYTES = 32 * 1024 * 1024;
+
+struct BufferPoolThreadCache;
+
+// Created on first use and never destroyed, ByteBuffers live in statics and thread locals that are torn down in any order
+struct BufferPoolGlobals
+{
+    moodycamel::ConcurrentQueue<void*> freeBlocks[BUFFERPOOL_CLASS_COUNT];
+
+    // Thread caches register themselves so the counters can be summed up, retired caches fold theirs into these
+    std::mutex cacheMutex;
+    std::vector<BufferPoolThreadCache*> caches;
+    u64 retiredHits = 0;
+    u64 retiredMisses = 0;
+
+    static BufferPoolGlobals& Get()
+    {
+        static BufferPoolGlobals* globals = new BufferPoolGlobals();
+        return *globals;
+    }
+};
+
+struct BufferPoolThreadCache
+{
+    void* blocks[BUFFERPOOL_CLASS_COUNT][THREAD_CACHE_CAPACITY];
+    u32 counts[BUFFERPOOL_CLASS_COUNT];
+
+    // Only ever written by the owning thread, atomic so stats can be read from anywhere
+    std::atomic<u64> hits;
+    std::atomic<u64> misses;
+
+    BufferPoolThreadCache() : counts(), hits(0), misses(0)
+    {
+        BufferPoolGlobals& globals = BufferPoolGlobals::Get();
+        std::lock_guard<std::mutex> lock(globals.cacheMutex);
+        globals.caches.push_back(this);
+    }
+
+    ~BufferPoolThreadCache()
+    {
+        BufferPoolGlobals& globals = BufferPoolGlobals::Get();
+        for (size_t i = 0; i < BUFFERPOOL_CLASS_COUNT; i++)
+        {
+            if (counts[i])
+                globals.freeBlocks[i].enqueue_bulk(blocks[i], counts[i]);
+        }
+
+        std::lock_guard<std::mutex> lock(globals.cacheMutex);
+        globals.caches.erase(std::find(globals.caches.begin(), globals.caches.end(), this));
+        globals.retiredHits += hits.load(std::memory_order_relaxed);
+        globals.retiredMisses += misses.load(std::memory_order_relaxed);
+    }
+
+    void CountHit() { hits.store(hits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+    void CountMiss() { misses.store(misses.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+};
+
+// Buffers can still be freed while a thread is shutting down, after its cache is gone they go straight to the freelists
+static thread_local bool threadCacheDestroyed = false;
+
+static BufferPoolThreadCache* GetThreadCache()
+{
+    if (threadCacheDestroyed)
+        return nullptr;
+
+    struct Holder
+    {
+        BufferPoolThreadCache cache;
+        ~Holder() { threadCacheDestroyed = true; }
+    };
+    thread_local Holder holder;
+    return &holder.cache;
+}
+
+std::atomic<u64> BufferPool::_oversized(0);
+
+size_t BufferPool::GetSizeClass(size_t size)
+{
+    if (size <= GetClassSize(0))
+        return 0;
+
+    size_t sizeClass = 1;
+    while (sizeClass < BUFFERPOOL_CLASS_COUNT && GetClassSize(sizeClass) < size)
+    {
+        sizeClass++;
+    }
+
+    return sizeClass;
+}
+
+void* BufferPool::Allocate(size_t size)
+{
+    size_t sizeClass = GetSizeClass(size);
+    if (sizeClass == BUFFERPOOL_CLASS_COUNT)
+    {
+        _oversized.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new(size);
+    }
+
+    BufferPoolThreadCache* cache = GetThreadCache();
+    if (!cache)
+        return ::operator new(GetClassSize(sizeClass));
+
+    if (cache->counts[sizeClass] == 0)
+    {
+        // Refill half the cache at once so the next allocations stay thread local
+        cache->counts[sizeClass] = static_cast<u32>(BufferPoolGlobals::Get().freeBlocks[sizeClass].try_dequeue_bulk(cache->blocks[sizeClass], TRANSFER_BATCH_SIZE));
+        if (cache->counts[sizeClass] == 0)
+        {
+            cache->CountMiss();
+            return ::operator new(GetClassSize(sizeClass));
+        }
+    }
+
+    cache->CountHit();
+    return cache->blocks[sizeClass][--cache->counts[sizeClass]];
+}
+
+void BufferPool::Deallocate(void* block, size_t size)
+{
+    if (!block)
+        return;
+
+    size_t sizeClass = GetSizeClass(size);
+    if (sizeClass == BUFFERPOOL_CLASS_COUNT)
+    {
+        ::operator delete(block);
+        return;
+    }
+
+    BufferPoolGlobals& globals = BufferPoolGlobals::Get();
+    size_t globalCapacity = std::max(GLOBAL_CLASS_BYTES / GetClassSize(sizeClass), static_cast<size_t>(THREAD_CACHE_CAPACITY));
+
+    BufferPoolThreadCache* cache = GetThreadCache();
+    if (!cache)
+    {
+        if (globals.freeBlocks[sizeClass].size_approx() >= globalCapacity)
+            ::operator delete(block);
+        else
+            globals.freeBlocks[sizeClass].enqueue(block);
+        return;
+    }
+
+    u32& count = cache->counts[sizeClass];
+    if (count == THREAD_CACHE_CAPACITY)
+    {
+        // Threads that mostly free, like the io threads completing writes, hand the oldest half over to the threads that allocate
+        count -= TRANSFER_BATCH_SIZE;
+        if (globals.freeBlocks[sizeClass].size_approx() >= globalCapacity)
+        {
+            for (u32 i = 0; i < TRANSFER_BATCH_SIZE; i++)
+            {
+                ::operator delete(cache->blocks[sizeClass][i]);
+            }
+        }
+        else
+        {
+            globals.freeBlocks[sizeClass].enqueue_bulk(cache->blocks[sizeClass], TRANSFER_BATCH_SIZE);
+        }
+        std::memmove(cache->blocks[sizeClass], cache->blocks[sizeClass] + TRANSFER_BATCH_SIZE, count * sizeof(void*));
+    }
+
+    cache->blocks[sizeClass][count++] = block;
+}
+
+u64 BufferPool::GetHits()
+{
+    BufferPoolGlobals& globals = BufferPoolGlobals::Get();
+    std::lock_guard<std::mutex> lock(globals.cacheMutex);
+
+    u64 hits = globals.retiredHits;
+    for (BufferPoolThreadCache* cache : globals.caches)
+    {
+        hits += cache->hits.load(std::memory_order_relaxed);
+    }
+    return hits;
+}
+
+u64 BufferPool::GetMisses()
+{
+    BufferPoolGlobals& globals = BufferPoolGlobals::Get();
+    std::lock_guard<std::mutex> lock(globals.cacheMutex);
+
+    u64 misses = globals.retiredMisses;
+    for (BufferPoolThreadCache* cache : globals.caches)
+    {
+        misses += cache->misses.load(std::memory_order_relaxed);
+    }
+    return misses;
+}
\ No newline at end of file
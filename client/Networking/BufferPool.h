@@ -0,0 +1,73 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include "../NovusTypes.h"
+
+// Size classes are powers of two from 64 bytes to 64 KB, anything larger is allocated directly
+constexpr size_t BUFFERPOOL_MIN_CLASS_SHIFT = 6;
+constexpr size_t BUFFERPOOL_CLASS_COUNT = 11;
+
+// Recycles packet buffer memory. Every thread keeps a small cache per size class and only goes to the lock free global
+// freelists in batches, once packet traffic reaches a steady state buffers stop hitting the heap altogether.
+class BufferPool
+{
+public:
+    static void* Allocate(size_t size);
+    static void Deallocate(void* block, size_t size);
+
+    // Allocations served from a cache or freelist, allocations that had to hit the heap and ones too large to pool
+    static u64 GetHits();
+    static u64 GetMisses();
+    static u64 GetOversized() { return _oversized.load(std::memory_order_relaxed); }
+
+    static constexpr size_t GetClassSize(size_t sizeClass) { return size_t(1) << (sizeClass + BUFFERPOOL_MIN_CLASS_SHIFT); }
+    static size_t GetSizeClass(size_t size);
+
+private:
+    BufferPool() { }
+
+    static std::atomic<u64> _oversized;
+};
+
+// Lets std containers draw from the BufferPool, stateless so containers using it still move in constant time
+template <typename T>
+struct PooledAllocator
+{
+    typedef T value_type;
+
+    PooledAllocator() noexcept { }
+    template <typename U>
+    PooledAllocator(PooledAllocator<U> const&) noexcept { }
+
+    T* allocate(size_t count) { return static_cast<T*>(BufferPool::Allocate(count * sizeof(T))); }
+    void deallocate(T* pointer, size_t count) noexcept { BufferPool::Deallocate(pointer, count * sizeof(T)); }
+};
+
+template <typename T, typename U>
+bool operator==(PooledAllocator<T> const&, PooledAllocator<U> const&) noexcept { return true; }
+template <typename T, typename U>
+bool operator!=(PooledAllocator<T> const&, PooledAllocator<U> const&) noexcept { return false; }
\ No newline at end of file
@@ -24,6 +24,7 @@
 #pragma once
 
 #include "../NovusTypes.h"
+#include "BufferPool.h"
 #include <vector>
 #include <cassert>
 
@@ -38,6 +39,22 @@ public:
     {
         _bufferData.reserve(reserveSize);
     }
+    ByteBuffer(ByteBuffer const& other) = default;
+    ByteBuffer(ByteBuffer&& other) noexcept : _readPos(other._readPos), _writePos(other._writePos), _bufferData(std::move(other._bufferData))
+    {
+        other._readPos = 0;
+        other._writePos = 0;
+    }
+    ByteBuffer& operator=(ByteBuffer const& other) = default;
+    ByteBuffer& operator=(ByteBuffer&& other) noexcept
+    {
+        _readPos = other._readPos;
+        _writePos = other._writePos;
+        _bufferData = std::move(other._bufferData);
+        other._readPos = 0;
+        other._writePos = 0;
+        return *this;
+    }
     virtual ~ByteBuffer() { }
 
     void ReadPackedGUID(u64& guid)
@@ -245,5 +262,6 @@ public:
 
     size_t _readPos, _writePos;
 private:
-    std::vector<u8> _bufferData;
+    // Backed by the BufferPool so short lived packets don't allocate once the pool has warmed up
+    std::vector<u8, PooledAllocator<u8>> _bufferData;
 };
\ No newline at end of file
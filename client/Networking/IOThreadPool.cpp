@@ -0,0 +1,86 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+
+#include "IOThreadPool.h"
+#include "../Utils/DebugHandler.h"
+
+IOThreadPool::IOThreadPool(asio::io_service& ioService) : _ioService(ioService), _work(), _threads() { }
+
+IOThreadPool::~IOThreadPool()
+{
+    Stop();
+}
+
+u32 IOThreadPool::GetThreadCount(u32 requestedThreads)
+{
+    if (requestedThreads > 0)
+        return requestedThreads;
+
+    // hardware_concurrency is allowed to return 0 when it can't be determined
+    u32 hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads > 0 ? hardwareThreads : 1;
+}
+
+void IOThreadPool::Start(u32 threadCount)
+{
+    if (!_threads.empty())
+        return;
+
+    _work = std::make_unique<asio::io_service::work>(_ioService);
+
+    _threads.reserve(threadCount);
+    for (u32 i = 0; i < threadCount; i++)
+    {
+        _threads.emplace_back([this]
+        {
+            _ioService.run();
+        });
+    }
+
+    NC_LOG_MESSAGE("Started %u io threads", threadCount);
+}
+
+void IOThreadPool::Stop(std::chrono::milliseconds drainTimeout)
+{
+    if (_threads.empty())
+        return;
+
+    // Without the work guard the threads return from run on their own once nothing is left to do
+    _work.reset();
+
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + drainTimeout;
+    while (!_ioService.stopped() && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    _ioService.stop();
+
+    for (std::thread& thread : _threads)
+    {
+        if (thread.joinable())
+            thread.join();
+    }
+    _threads.clear();
+}
\ No newline at end of file
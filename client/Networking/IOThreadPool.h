@@ -0,0 +1,54 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <asio.hpp>
+#include "../NovusTypes.h"
+
+// Runs a single io_service on a pool of worker threads, connections use their own strand to keep their handlers ordered
+class IOThreadPool
+{
+public:
+    IOThreadPool(asio::io_service& ioService);
+    ~IOThreadPool();
+
+    // A thread count of 0 starts one thread per hardware core
+    static u32 GetThreadCount(u32 requestedThreads);
+
+    void Start(u32 threadCount);
+    // Handlers that are already queued, like closes posted to connection strands, get up to drainTimeout to run before
+    // the io_service is stopped and everything still pending is dropped
+    void Stop(std::chrono::milliseconds drainTimeout = std::chrono::milliseconds(0));
+
+    size_t GetRunningThreads() const { return _threads.size(); }
+
+private:
+    asio::io_service& _ioService;
+    std::unique_ptr<asio::io_service::work> _work;
+    std::vector<std::thread> _threads;
+};
\ No newline at end of file
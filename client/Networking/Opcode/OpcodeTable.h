@@ -0,0 +1,82 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include "../../NovusTypes.h"
+#include <array>
+
+// Which side sends an opcode, MSG_ opcodes travel both ways
+enum OpcodeDirection : u8
+{
+    OPCODE_DIRECTION_NONE       = 0,
+    OPCODE_DIRECTION_CLIENT     = 1,
+    OPCODE_DIRECTION_SERVER     = 2,
+    OPCODE_DIRECTION_BOTH       = 3
+};
+
+template <typename Status, typename Handler>
+struct OpcodeHandler
+{
+    Handler handler;
+    Status status;
+    u32 minSize;
+    OpcodeDirection direction;
+};
+
+// Handler table indexed directly by opcode. It's filled in at compile time so looking up a handler is a bounds check
+// and an array load, slots without a handler stay zeroed.
+template <typename Entry, size_t Count>
+class OpcodeTable
+{
+public:
+    constexpr OpcodeTable() : _entries() { }
+
+    constexpr void Register(u32 opcode, Entry const& entry)
+    {
+        _entries[opcode] = entry;
+    }
+
+    constexpr Entry const* Find(u32 opcode) const
+    {
+        if (opcode >= Count || !_entries[opcode].handler)
+            return nullptr;
+
+        return &_entries[opcode];
+    }
+
+    // Used to static_assert that a table only handles what its side can receive
+    constexpr bool Accepts(OpcodeDirection direction) const
+    {
+        for (size_t i = 0; i < Count; i++)
+        {
+            if (_entries[i].handler && !(_entries[i].direction & direction))
+                return false;
+        }
+
+        return true;
+    }
+
+private:
+    std::array<Entry, Count> _entries;
+};
\ No newline at end of file
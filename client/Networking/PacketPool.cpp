@@ -0,0 +1,56 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+
+#include "PacketPool.h"
+
+// Anything released beyond this is freed instead of being kept around after a burst of large messages
+constexpr size_t MAX_FREE_BUFFERS = 1024;
+constexpr size_t BUFFER_RESERVE_SIZE = 256;
+
+moodycamel::ConcurrentQueue<ByteBuffer*> PacketPool::_freeBuffers;
+
+ByteBuffer* PacketPool::Acquire()
+{
+    ByteBuffer* buffer = nullptr;
+    if (_freeBuffers.try_dequeue(buffer))
+        return buffer;
+
+    return new ByteBuffer(BUFFER_RESERVE_SIZE);
+}
+
+void PacketPool::Release(ByteBuffer* buffer)
+{
+    if (!buffer)
+        return;
+
+    if (_freeBuffers.size_approx() >= MAX_FREE_BUFFERS)
+    {
+        delete buffer;
+        return;
+    }
+
+    // Clean keeps the capacity so the next Acquire doesn't have to allocate
+    buffer->Clean();
+    _freeBuffers.enqueue(buffer);
+}
\ No newline at end of file
@@ -0,0 +1,249 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#include "PacketRecorder.h"
+#include "../Utils/DebugHandler.h"
+#include <algorithm>
+#include <cstring>
+#include <zlib.h>
+
+struct PacketRecorderBuffer
+{
+    std::vector<u8> data;
+    std::vector<u8> compressed;
+    u32 recordCount = 0;
+    u64 firstTimestamp = 0;
+    u64 lastTimestamp = 0;
+    // Opcode key to the amount of records in this buffer, merged into the file's opcode index on flush
+    robin_hood::unordered_map<u32, u32> opcodeCounts;
+};
+
+std::atomic<bool> PacketRecorder::_isRecording(false);
+PacketRecorder::Clock::time_point PacketRecorder::_startTime;
+size_t PacketRecorder::_blockSize = 0;
+std::mutex PacketRecorder::_fileMutex;
+std::FILE* PacketRecorder::_file = nullptr;
+u64 PacketRecorder::_fileOffset = 0;
+u64 PacketRecorder::_rawSize = 0;
+std::vector<PacketCaptureBlock> PacketRecorder::_blocks;
+robin_hood::unordered_map<u32, PacketRecorder::OpcodeIndex> PacketRecorder::_opcodeIndex;
+std::vector<std::unique_ptr<PacketRecorderBuffer>> PacketRecorder::_buffers;
+
+bool PacketRecorder::Start(std::string const& path, size_t blockSize)
+{
+    std::lock_guard<std::mutex> lock(_fileMutex);
+    if (_file)
+        return false;
+
+    _file = std::fopen(path.c_str(), "wb");
+    if (!_file)
+    {
+        NC_LOG_ERROR("PacketRecorder: Failed to open %s", path.c_str());
+        return false;
+    }
+
+    PacketCaptureHeader header;
+    header.magic = PACKET_CAPTURE_MAGIC;
+    header.version = PACKET_CAPTURE_VERSION;
+    header.headerSize = sizeof(PacketCaptureHeader);
+    header.startTime = static_cast<u64>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+    std::fwrite(&header, sizeof(header), 1, _file);
+
+    _blockSize = std::clamp(blockSize, static_cast<size_t>(4096), static_cast<size_t>(PACKET_CAPTURE_MAX_BLOCK_SIZE / 2));
+    _fileOffset = sizeof(header);
+    _rawSize = 0;
+    _blocks.clear();
+    _opcodeIndex.clear();
+    _startTime = Clock::now();
+    _isRecording = true;
+
+    NC_LOG_MESSAGE("PacketRecorder: Capturing traffic to %s", path.c_str());
+    return true;
+}
+
+void PacketRecorder::Stop()
+{
+    if (!_isRecording.exchange(false))
+        return;
+
+    for (auto& buffer : _buffers)
+    {
+        FlushBuffer(buffer.get());
+    }
+
+    std::lock_guard<std::mutex> lock(_fileMutex);
+    WriteIndex();
+    std::fclose(_file);
+    _file = nullptr;
+
+    u64 packetCount = 0;
+    for (PacketCaptureBlock const& block : _blocks)
+    {
+        packetCount += block.recordCount;
+    }
+
+    NC_LOG_MESSAGE("PacketRecorder: Wrote %llu packets in %u blocks, %.2f MB raw, %.2f MB compressed", packetCount, static_cast<u32>(_blocks.size()), _rawSize / (1024.0 * 1024.0), _fileOffset / (1024.0 * 1024.0));
+}
+
+PacketRecorderBuffer* PacketRecorder::GetThreadBuffer()
+{
+    // Buffers are owned by the recorder so Stop can still flush them, threads only keep a pointer
+    thread_local PacketRecorderBuffer* threadBuffer = nullptr;
+    if (!threadBuffer)
+    {
+        threadBuffer = new PacketRecorderBuffer();
+        threadBuffer->data.reserve(_blockSize + 1024);
+
+        std::lock_guard<std::mutex> lock(_fileMutex);
+        _buffers.emplace_back(threadBuffer);
+    }
+
+    return threadBuffer;
+}
+
+void PacketRecorder::Append(u32 botId, u16 opcode, u8 flags, u8 const* data, u32 size)
+{
+    PacketRecorderBuffer* buffer = GetThreadBuffer();
+
+    PacketRecordHeader header;
+    header.timestamp = static_cast<u64>(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - _startTime).count());
+    header.botId = botId;
+    header.opcode = opcode;
+    header.flags = flags;
+    header.reserved = 0;
+    header.size = size;
+
+    u8 const* headerBytes = reinterpret_cast<u8 const*>(&header);
+    buffer->data.insert(buffer->data.end(), headerBytes, headerBytes + sizeof(header));
+    buffer->data.insert(buffer->data.end(), data, data + size);
+
+    if (buffer->recordCount == 0)
+        buffer->firstTimestamp = header.timestamp;
+    buffer->lastTimestamp = header.timestamp;
+    buffer->recordCount++;
+    buffer->opcodeCounts[opcode | (static_cast<u32>(flags) << 16)]++;
+
+    if (buffer->data.size() >= _blockSize)
+        FlushBuffer(buffer);
+}
+
+void PacketRecorder::FlushBuffer(PacketRecorderBuffer* buffer)
+{
+    if (buffer->recordCount == 0)
+        return;
+
+    // Compressing happens outside of the lock, only the write itself is serialized
+    uLongf compressedSize = compressBound(static_cast<uLong>(buffer->data.size()));
+    buffer->compressed.resize(compressedSize);
+    i32 result = compress2(buffer->compressed.data(), &compressedSize, buffer->data.data(), static_cast<uLong>(buffer->data.size()), Z_BEST_SPEED);
+
+    if (result == Z_OK)
+    {
+        std::lock_guard<std::mutex> lock(_fileMutex);
+        if (_file)
+        {
+            PacketCaptureBlock block;
+            block.offset = _fileOffset;
+            block.compressedSize = static_cast<u32>(compressedSize);
+            block.rawSize = static_cast<u32>(buffer->data.size());
+            block.recordCount = buffer->recordCount;
+            block.reserved = 0;
+            block.firstTimestamp = buffer->firstTimestamp;
+            block.lastTimestamp = buffer->lastTimestamp;
+
+            std::fwrite(buffer->compressed.data(), 1, compressedSize, _file);
+            _fileOffset += compressedSize;
+            _rawSize += block.rawSize;
+
+            u32 blockIndex = static_cast<u32>(_blocks.size());
+            _blocks.push_back(block);
+
+            for (auto& opcodeCount : buffer->opcodeCounts)
+            {
+                OpcodeIndex& index = _opcodeIndex[opcodeCount.first];
+                index.packetCount += opcodeCount.second;
+                index.blocks.push_back(blockIndex);
+            }
+        }
+    }
+    else
+    {
+        NC_LOG_ERROR("PacketRecorder: Failed to compress a block of %u records (%d)", buffer->recordCount, result);
+    }
+
+    buffer->data.clear();
+    buffer->recordCount = 0;
+    buffer->opcodeCounts.clear();
+}
+
+void PacketRecorder::WriteIndex()
+{
+    PacketCaptureFooter footer;
+    footer.blockTableOffset = _fileOffset;
+    footer.blockCount = static_cast<u32>(_blocks.size());
+    std::fwrite(_blocks.data(), sizeof(PacketCaptureBlock), _blocks.size(), _file);
+    _fileOffset += sizeof(PacketCaptureBlock) * _blocks.size();
+
+    // Sorted by flags, then opcode, so readers can binary search the opcode table
+    std::vector<u32> keys;
+    keys.reserve(_opcodeIndex.size());
+    for (auto& index : _opcodeIndex)
+    {
+        keys.push_back(index.first);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<PacketCaptureOpcode> opcodes;
+    std::vector<u32> blockLists;
+    opcodes.reserve(keys.size());
+    for (u32 key : keys)
+    {
+        OpcodeIndex const& index = _opcodeIndex[key];
+
+        PacketCaptureOpcode opcode;
+        opcode.opcode = static_cast<u16>(key);
+        opcode.flags = static_cast<u8>(key >> 16);
+        opcode.reserved = 0;
+        opcode.blockCount = static_cast<u32>(index.blocks.size());
+        opcode.blockListIndex = static_cast<u32>(blockLists.size());
+        opcode.reserved2 = 0;
+        opcode.packetCount = index.packetCount;
+        opcodes.push_back(opcode);
+
+        blockLists.insert(blockLists.end(), index.blocks.begin(), index.blocks.end());
+    }
+
+    footer.opcodeTableOffset = _fileOffset;
+    footer.opcodeCount = static_cast<u32>(opcodes.size());
+    std::fwrite(opcodes.data(), sizeof(PacketCaptureOpcode), opcodes.size(), _file);
+    _fileOffset += sizeof(PacketCaptureOpcode) * opcodes.size();
+
+    footer.blockListOffset = _fileOffset;
+    footer.blockListCount = static_cast<u32>(blockLists.size());
+    std::fwrite(blockLists.data(), sizeof(u32), blockLists.size(), _file);
+    _fileOffset += sizeof(u32) * blockLists.size();
+
+    footer.magic = PACKET_CAPTURE_MAGIC;
+    std::fwrite(&footer, sizeof(footer), 1, _file);
+    _fileOffset += sizeof(footer);
+}
\ No newline at end of file
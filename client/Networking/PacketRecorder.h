@@ -0,0 +1,158 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <robin_hood.h>
+#include "../NovusTypes.h"
+
+enum PacketRecordFlags : u8
+{
+    PACKETRECORD_INBOUND    = 0x00,
+    PACKETRECORD_OUTBOUND   = 0x01,
+    // Auth commands and world opcodes overlap, world packets are told apart by this flag
+    PACKETRECORD_WORLD      = 0x02
+};
+
+// Capture file layout, everything is little endian and packed so a reader can map the file and cast straight into it:
+// header, zlib compressed blocks of records, block table, opcode table, block lists and the footer at the very end.
+#pragma pack(push, 1)
+struct PacketCaptureHeader
+{
+    u32 magic;
+    u16 version;
+    u16 headerSize;
+    // Wall clock time the capture started at in microseconds since the epoch, record timestamps are relative to it
+    u64 startTime;
+};
+
+// Auth records hold the whole command including the command byte, world records only hold the body since the header
+// is framing and encryption
+struct PacketRecordHeader
+{
+    u64 timestamp;
+    u32 botId;
+    u16 opcode;
+    u8 flags;
+    u8 reserved;
+    u32 size;
+};
+
+// A block only ever holds records from one io thread, records of a single bot can be spread over several blocks
+struct PacketCaptureBlock
+{
+    u64 offset;
+    u32 compressedSize;
+    u32 rawSize;
+    u32 recordCount;
+    u32 reserved;
+    u64 firstTimestamp;
+    u64 lastTimestamp;
+};
+
+// Lists the blocks an opcode shows up in, blockListIndex points into the u32 block lists following the opcode table
+struct PacketCaptureOpcode
+{
+    u16 opcode;
+    u8 flags;
+    u8 reserved;
+    u32 blockCount;
+    u32 blockListIndex;
+    u32 reserved2;
+    u64 packetCount;
+};
+
+struct PacketCaptureFooter
+{
+    u64 blockTableOffset;
+    u64 opcodeTableOffset;
+    u64 blockListOffset;
+    u32 blockCount;
+    u32 opcodeCount;
+    u32 blockListCount;
+    u32 magic;
+};
+#pragma pack(pop)
+
+constexpr u32 PACKET_CAPTURE_MAGIC = 0x4350434E; // NCPC
+constexpr u16 PACKET_CAPTURE_VERSION = 1;
+// Readers reject blocks claiming more raw bytes than this, the recorder keeps its flush threshold at half of it so the
+// record that crosses the threshold always fits
+constexpr u32 PACKET_CAPTURE_MAX_BLOCK_SIZE = 16 * 1024 * 1024;
+
+struct PacketRecorderBuffer;
+
+// Appends every packet the bots send and receive, decrypted, to a capture file. Records go into a buffer owned by the
+// recording thread and only a full buffer is compressed and written, so the io threads never contend on a lock per packet.
+class PacketRecorder
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    static bool Start(std::string const& path, size_t blockSize);
+    // Has to be called after the io threads stopped since it flushes the buffers they record into
+    static void Stop();
+
+    static bool IsRecording() { return _isRecording.load(std::memory_order_relaxed); }
+
+    static void Record(u32 botId, u16 opcode, u8 flags, u8 const* data, u32 size)
+    {
+        if (IsRecording())
+            Append(botId, opcode, flags, data, size);
+    }
+
+private:
+    PacketRecorder() { }
+
+    static void Append(u32 botId, u16 opcode, u8 flags, u8 const* data, u32 size);
+    static PacketRecorderBuffer* GetThreadBuffer();
+    static void FlushBuffer(PacketRecorderBuffer* buffer);
+    static void WriteIndex();
+
+    struct OpcodeIndex
+    {
+        u64 packetCount = 0;
+        std::vector<u32> blocks;
+    };
+
+    static std::atomic<bool> _isRecording;
+    static Clock::time_point _startTime;
+    static size_t _blockSize;
+
+    // Guards the file and the index, only taken once per flushed block
+    static std::mutex _fileMutex;
+    static std::FILE* _file;
+    static u64 _fileOffset;
+    static u64 _rawSize;
+    static std::vector<PacketCaptureBlock> _blocks;
+    // Keyed by opcode | flags << 16
+    static robin_hood::unordered_map<u32, OpcodeIndex> _opcodeIndex;
+    static std::vector<std::unique_ptr<PacketRecorderBuffer>> _buffers;
+};
\ No newline at end of file
@@ -0,0 +1,150 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include "../NovusTypes.h"
+#include <memory>
+#include <cstring>
+#include <algorithm>
+#include <cassert>
+
+// Fixed capacity receive buffer that sockets read straight into. The read and write positions wrap around instead of
+// moving unread data to the front, a packet that straddles the end is made contiguous by copying only its wrapped part
+// into the slack area behind the buffer.
+class RingBuffer
+{
+public:
+    RingBuffer(size_t capacity, size_t slack) : _readPos(0), _writePos(0)
+    {
+        // Round up to a power of two so wrapping a position is a single mask
+        _capacity = 1;
+        while (_capacity < capacity)
+            _capacity <<= 1;
+
+        _mask = _capacity - 1;
+        _slack = slack;
+        _data.reset(new u8[_capacity + _slack]);
+    }
+
+    template <typename T>
+    void Read(T& destination)
+    {
+        Peek(&destination, 0, sizeof(T));
+        ReadBytes(sizeof(T));
+    }
+    void Read(void* destination, size_t length)
+    {
+        Peek(destination, 0, length);
+        ReadBytes(length);
+    }
+    template <typename T>
+    T PeekAt(size_t offset) const
+    {
+        T value;
+        Peek(&value, offset, sizeof(T));
+        return value;
+    }
+    void Peek(void* destination, size_t offset, size_t length) const
+    {
+        assert(offset + length <= GetActualSize());
+
+        size_t start = (_readPos + offset) & _mask;
+        size_t firstPart = _capacity - start;
+        if (firstPart >= length)
+        {
+            std::memcpy(destination, &_data[start], length);
+        }
+        else
+        {
+            std::memcpy(destination, &_data[start], firstPart);
+            std::memcpy(static_cast<u8*>(destination) + firstPart, &_data[0], length - firstPart);
+        }
+    }
+
+    // Makes the next size bytes readable through GetReadPointer, returns false if they don't fit into the slack
+    bool Linearize(size_t size)
+    {
+        assert(size <= GetActualSize());
+
+        size_t contiguous = GetContiguousReadSize();
+        if (contiguous >= size)
+            return true;
+
+        size_t wrapped = size - contiguous;
+        if (wrapped > _slack)
+            return false;
+
+        std::memcpy(&_data[_capacity], &_data[0], wrapped);
+        return true;
+    }
+
+    // The free space is split into at most two regions, the second one is only used when the first one ends at the end of the buffer
+    void GetWriteRegions(u8*& first, size_t& firstSize, u8*& second, size_t& secondSize)
+    {
+        size_t spaceLeft = GetSpaceLeft();
+        size_t start = _writePos & _mask;
+
+        first = &_data[start];
+        firstSize = std::min(spaceLeft, _capacity - start);
+        second = &_data[0];
+        secondSize = spaceLeft - firstSize;
+    }
+
+    void WriteBytes(size_t size)
+    {
+        assert(size <= GetSpaceLeft());
+        _writePos += size;
+    }
+    void ReadBytes(size_t size)
+    {
+        assert(size <= GetActualSize());
+        _readPos += size;
+
+        // Start over at the front whenever we run empty, keeping packets away from the wrap point
+        if (_readPos == _writePos)
+            Clean();
+    }
+    void Clean()
+    {
+        _readPos = 0;
+        _writePos = 0;
+    }
+
+    u8* GetReadPointer() { return &_data[_readPos & _mask]; }
+    // Byte at offset from the read position, used to work on bytes in place without making them contiguous first
+    u8& At(size_t offset) { return _data[(_readPos + offset) & _mask]; }
+    size_t GetContiguousReadSize() const { return std::min(GetActualSize(), _capacity - (_readPos & _mask)); }
+    size_t GetActualSize() const { return _writePos - _readPos; }
+    size_t GetSpaceLeft() const { return _capacity - GetActualSize(); }
+    size_t GetCapacity() const { return _capacity; }
+    size_t GetSlack() const { return _slack; }
+    bool IsEmpty() const { return _readPos == _writePos; }
+
+private:
+    std::unique_ptr<u8[]> _data;
+    size_t _capacity;
+    size_t _mask;
+    size_t _slack;
+    size_t _readPos, _writePos;
+};
\ No newline at end of file
@@ -366,6 +366,11 @@ void Context::execute()
 	AB_SCRIPT_ASSERT(r == asEXECUTION_FINISHED, "Error executing call to script.", AB_THROW, this->_pool.engine());
 }
 
+ASContext* Context::asContext()
+{
+	return this->_context;
+}
+
 void Context::setAddress( void* value )
 {
 	this->_context->SetArgAddress(this->_params++, value);
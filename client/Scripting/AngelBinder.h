@@ -479,6 +479,11 @@ public:
 	///
 	void execute();
 
+	///
+	/// AngelScript context
+	///
+	ASContext* asContext();
+
 	///
 	/// Prepares the execution of the context
 	///
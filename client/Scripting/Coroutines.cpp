@@ -0,0 +1,394 @@
+#include "Coroutines.h"
+#include "../Utils/DebugHandler.h"
+#include "PacketHooks.h"
+#include "ScriptProfiler.h"
+#include "AngelBinder.h"
+#include <algorithm>
+
+// Sleeps and opcode timeouts are kept at millisecond resolution, one rotation covers a second
+constexpr u64 COROUTINE_TIMER_RESOLUTION = 1;
+constexpr size_t COROUTINE_TIMER_SLOTS = 1024;
+constexpr u32 NO_COROUTINE = 0xFFFFFFFF;
+
+moodycamel::ConcurrentQueue<CoroutineEvent> CoroutineScheduler::_events;
+std::array<std::atomic<u32>, Common::NUM_MSG_TYPES> CoroutineScheduler::_opcodeWaiters = {};
+
+std::vector<CoroutineScheduler::Coroutine> CoroutineScheduler::_coroutines;
+std::vector<u32> CoroutineScheduler::_freeCoroutines;
+std::vector<asIScriptContext*> CoroutineScheduler::_contextPool;
+thread_local u32 CoroutineScheduler::_current = NO_COROUTINE;
+
+std::vector<u64> CoroutineScheduler::_yielded;
+TimerWheel<u64> CoroutineScheduler::_timers(COROUTINE_TIMER_RESOLUTION, COROUTINE_TIMER_SLOTS);
+robin_hood::unordered_flat_map<u64, std::vector<u64>> CoroutineScheduler::_opcodeWaits;
+
+std::chrono::steady_clock::time_point CoroutineScheduler::_startTime = std::chrono::steady_clock::now();
+u64 CoroutineScheduler::_tableVersion = 0;
+
+void CoroutineScheduler::PostStart(u32 botId)
+{
+	// Nothing to start, so bots don't fill the queue while no scenario is loaded
+	if (PacketHooks::GetTable().scenarios.empty())
+		return;
+
+	_events.enqueue({ COROUTINE_EVENT_START, 0, botId });
+}
+
+void CoroutineScheduler::PostStop(u32 botId)
+{
+	if (PacketHooks::GetTable().scenarios.empty())
+		return;
+
+	_events.enqueue({ COROUTINE_EVENT_STOP, 0, botId });
+}
+
+void CoroutineScheduler::PostOpcode(u32 botId, u16 opcode)
+{
+	_events.enqueue({ COROUTINE_EVENT_OPCODE, opcode, botId });
+}
+
+u64 CoroutineScheduler::GetTime()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _startTime).count();
+}
+
+void CoroutineScheduler::Update()
+{
+	// Scenarios that were removed or replaced by a reload stop where they are
+	u64 tableVersion = PacketHooks::GetVersion();
+	if (_tableVersion != tableVersion)
+	{
+		_tableVersion = tableVersion;
+		AbortRemovedScenarios();
+	}
+
+	std::vector<u32> stoppedBots;
+	std::vector<u64> ready;
+
+	CoroutineEvent events[64];
+	size_t count;
+	while ((count = _events.try_dequeue_bulk(events, 64)) > 0)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			CoroutineEvent const& event = events[i];
+
+			if (event.type == COROUTINE_EVENT_START)
+			{
+				for (PacketHooks::Hook const& hook : PacketHooks::GetTable().scenarios)
+				{
+					Start(hook.function, event.botId);
+				}
+			}
+			else if (event.type == COROUTINE_EVENT_STOP)
+			{
+				stoppedBots.push_back(event.botId);
+			}
+			else
+			{
+				auto itr = _opcodeWaits.find(MakeWaitKey(event.botId, event.opcode));
+				if (itr == _opcodeWaits.end())
+					continue;
+
+				// Taken out of the map first since resumed coroutines can wait for the same opcode again
+				std::vector<u64> handles = std::move(itr->second);
+				_opcodeWaits.erase(itr);
+
+				for (u64 handle : handles)
+				{
+					if (!IsCurrentWait(handle, COROUTINE_OPCODE))
+						continue;
+
+					u32 index = static_cast<u32>(handle);
+					_opcodeWaiters[event.opcode].fetch_sub(1, std::memory_order_relaxed);
+					_coroutines[index].wait = COROUTINE_RUNNING;
+					_coroutines[index].timedOut = false;
+					Resume(index);
+				}
+			}
+		}
+	}
+
+	// Disconnected bots are collected so a mass disconnect costs one pass over the coroutines
+	if (!stoppedBots.empty())
+	{
+		std::sort(stoppedBots.begin(), stoppedBots.end());
+		for (u32 i = 0; i < _coroutines.size(); i++)
+		{
+			if (_coroutines[i].context && std::binary_search(stoppedBots.begin(), stoppedBots.end(), _coroutines[i].botId))
+				Abort(i);
+		}
+	}
+
+	// Expired timers are collected before resuming anything so a coroutine sleeping again can't fire within the same advance
+	_timers.Advance(GetTime(), [&ready](u64 handle) { ready.push_back(handle); });
+	for (u64 handle : ready)
+	{
+		u32 index = static_cast<u32>(handle);
+
+		if (IsCurrentWait(handle, COROUTINE_OPCODE))
+		{
+			StopWaiting(index);
+			_coroutines[index].timedOut = true;
+		}
+		else if (!IsCurrentWait(handle, COROUTINE_SLEEP))
+		{
+			continue;
+		}
+
+		_coroutines[index].wait = COROUTINE_RUNNING;
+		Resume(index);
+	}
+
+	// Coroutines yielding again from here are resumed on the next tick
+	ready.clear();
+	ready.swap(_yielded);
+	for (u64 handle : ready)
+	{
+		if (!IsCurrentWait(handle, COROUTINE_YIELD))
+			continue;
+
+		u32 index = static_cast<u32>(handle);
+		_coroutines[index].wait = COROUTINE_RUNNING;
+		Resume(index);
+	}
+}
+
+void CoroutineScheduler::GetStatus(CoroutineStatus& status)
+{
+	status = CoroutineStatus();
+	status.pooledContexts = static_cast<u32>(_contextPool.size());
+
+	for (Coroutine const& coroutine : _coroutines)
+	{
+		if (!coroutine.context)
+			continue;
+
+		if (coroutine.wait == COROUTINE_SLEEP)
+		{
+			status.sleeping++;
+		}
+		else if (coroutine.wait == COROUTINE_OPCODE)
+		{
+			status.waiting++;
+		}
+		else
+		{
+			status.running++;
+		}
+	}
+}
+
+void CoroutineScheduler::Start(asIScriptFunction* function, u32 botId)
+{
+	asIScriptContext* context;
+	if (_contextPool.empty())
+	{
+		context = function->GetEngine()->CreateContext();
+		if (!context)
+		{
+			NC_LOG_ERROR("Failed to create a context for scenario '%s'", function->GetName());
+			return;
+		}
+	}
+	else
+	{
+		context = _contextPool.back();
+		_contextPool.pop_back();
+	}
+
+	if (context->Prepare(function) < 0)
+	{
+		NC_LOG_ERROR("Failed to prepare scenario '%s'", function->GetName());
+		_contextPool.push_back(context);
+		return;
+	}
+	context->SetArgDWord(0, botId);
+
+	u32 index;
+	if (_freeCoroutines.empty())
+	{
+		index = static_cast<u32>(_coroutines.size());
+		_coroutines.emplace_back();
+	}
+	else
+	{
+		index = _freeCoroutines.back();
+		_freeCoroutines.pop_back();
+	}
+
+	Coroutine& coroutine = _coroutines[index];
+	coroutine.context = context;
+	coroutine.function = function;
+	coroutine.botId = botId;
+	coroutine.wait = COROUTINE_RUNNING;
+	coroutine.timedOut = false;
+
+	Resume(index);
+}
+
+void CoroutineScheduler::Resume(u32 index)
+{
+	asIScriptContext* context = _coroutines[index].context;
+
+	u32 previous = _current;
+	_current = index;
+	int result;
+	{
+		ScriptProfiler::Scope scope(context, "Scenario");
+		result = context->Execute();
+	}
+	_current = previous;
+
+	if (result == asEXECUTION_SUSPENDED)
+	{
+		Suspend(index);
+		return;
+	}
+
+	if (result == asEXECUTION_EXCEPTION)
+	{
+		asIScriptFunction* function = context->GetExceptionFunction();
+		NC_LOG_ERROR("Scenario for bot %u threw '%s' in %s line %d", _coroutines[index].botId, context->GetExceptionString(), function ? function->GetDeclaration() : "unknown", context->GetExceptionLineNumber());
+	}
+
+	Release(index);
+}
+
+void CoroutineScheduler::Suspend(u32 index)
+{
+	Coroutine& coroutine = _coroutines[index];
+
+	// Suspended without going through one of our functions, treat it like a yield
+	if (coroutine.wait == COROUTINE_RUNNING)
+		coroutine.wait = COROUTINE_YIELD;
+
+	if (coroutine.wait == COROUTINE_YIELD)
+		_yielded.push_back(MakeHandle(index, coroutine.waitId));
+}
+
+void CoroutineScheduler::Release(u32 index)
+{
+	Coroutine& coroutine = _coroutines[index];
+
+	// Pooled contexts keep the stack memory they already allocated
+	coroutine.context->Unprepare();
+	_contextPool.push_back(coroutine.context);
+
+	coroutine.context = nullptr;
+	coroutine.function = nullptr;
+	coroutine.waitId++;
+	_freeCoroutines.push_back(index);
+}
+
+void CoroutineScheduler::Abort(u32 index)
+{
+	StopWaiting(index);
+	_coroutines[index].context->Abort();
+	Release(index);
+}
+
+void CoroutineScheduler::StopWaiting(u32 index)
+{
+	Coroutine& coroutine = _coroutines[index];
+	if (coroutine.wait != COROUTINE_OPCODE)
+		return;
+
+	auto itr = _opcodeWaits.find(MakeWaitKey(coroutine.botId, coroutine.opcode));
+	if (itr != _opcodeWaits.end())
+	{
+		std::vector<u64>& handles = itr->second;
+		handles.erase(std::remove(handles.begin(), handles.end(), MakeHandle(index, coroutine.waitId)), handles.end());
+
+		if (handles.empty())
+			_opcodeWaits.erase(itr);
+	}
+
+	_opcodeWaiters[coroutine.opcode].fetch_sub(1, std::memory_order_relaxed);
+	coroutine.wait = COROUTINE_RUNNING;
+}
+
+void CoroutineScheduler::AbortRemovedScenarios()
+{
+	std::vector<PacketHooks::Hook> const& scenarios = PacketHooks::GetTable().scenarios;
+
+	for (u32 i = 0; i < _coroutines.size(); i++)
+	{
+		asIScriptFunction* function = _coroutines[i].function;
+		if (!function)
+			continue;
+
+		if (std::none_of(scenarios.begin(), scenarios.end(), [function](PacketHooks::Hook const& hook) { return hook.function == function; }))
+			Abort(i);
+	}
+}
+
+bool CoroutineScheduler::IsCurrentWait(u64 handle, CoroutineWait wait)
+{
+	Coroutine const& coroutine = _coroutines[static_cast<u32>(handle)];
+	return coroutine.context && coroutine.waitId == static_cast<u32>(handle >> 32) && coroutine.wait == wait;
+}
+
+// The context only suspends once the calling native returns, the caller fills in what the coroutine waits for
+CoroutineScheduler::Coroutine* CoroutineScheduler::SuspendCurrent(char const* function)
+{
+	asIScriptContext* context = asGetActiveContext();
+	if (_current == NO_COROUTINE || !context || _coroutines[_current].context != context)
+	{
+		NC_LOG_ERROR("%s can only be called from a bot scenario", function);
+		return nullptr;
+	}
+
+	Coroutine* coroutine = &_coroutines[_current];
+	coroutine->waitId++;
+	context->Suspend();
+	return coroutine;
+}
+
+void CoroutineScheduler::SuspendForTick()
+{
+	if (Coroutine* coroutine = SuspendCurrent("Yield"))
+	{
+		coroutine->wait = COROUTINE_YIELD;
+	}
+}
+
+void CoroutineScheduler::SuspendFor(u32 milliseconds)
+{
+	if (Coroutine* coroutine = SuspendCurrent("Sleep"))
+	{
+		coroutine->wait = COROUTINE_SLEEP;
+		_timers.Schedule(GetTime() + milliseconds, MakeHandle(_current, coroutine->waitId));
+	}
+}
+
+void CoroutineScheduler::SuspendForOpcode(u16 opcode, u32 timeoutMilliseconds)
+{
+	if (opcode >= Common::NUM_MSG_TYPES)
+	{
+		NC_LOG_ERROR("WaitForOpcode called with invalid opcode %u", (u32)opcode);
+		return;
+	}
+
+	if (Coroutine* coroutine = SuspendCurrent("WaitForOpcode"))
+	{
+		u64 handle = MakeHandle(_current, coroutine->waitId);
+		coroutine->wait = COROUTINE_OPCODE;
+		coroutine->opcode = opcode;
+
+		_opcodeWaits[MakeWaitKey(coroutine->botId, opcode)].push_back(handle);
+		_opcodeWaiters[opcode].fetch_add(1, std::memory_order_relaxed);
+
+		// Waits without a timeout only end when the packet arrives or the bot disconnects
+		if (timeoutMilliseconds > 0)
+			_timers.Schedule(GetTime() + timeoutMilliseconds, handle);
+	}
+}
+
+bool CoroutineScheduler::TimedOut()
+{
+	if (_current == NO_COROUTINE)
+		return false;
+
+	return _coroutines[_current].timedOut;
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+#pragma once
+#include "../NovusTypes.h"
+#include "../Networking/Opcode/Opcode.h"
+#include "../Utils/ConcurrentQueue.h"
+#include "../Utils/TimerWheel.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <robin_hood.h>
+
+class asIScriptContext;
+class asIScriptFunction;
+
+enum CoroutineWait : u8
+{
+	COROUTINE_RUNNING,
+	COROUTINE_YIELD,
+	COROUTINE_SLEEP,
+	COROUTINE_OPCODE
+};
+
+enum CoroutineEventType : u8
+{
+	COROUTINE_EVENT_START,
+	COROUTINE_EVENT_STOP,
+	COROUTINE_EVENT_OPCODE
+};
+
+// Posted from the io threads, the scheduler only ever touches coroutines from the tick thread
+struct CoroutineEvent
+{
+	CoroutineEventType type;
+	u16 opcode;
+	u32 botId;
+};
+
+struct CoroutineStatus
+{
+	u32 running = 0;
+	u32 sleeping = 0;
+	u32 waiting = 0;
+	u32 pooledContexts = 0;
+};
+
+// Runs bot scenario scripts as coroutines, a scenario suspends its context whenever it sleeps or waits for a packet and
+// gets resumed from Update once its timer fires or the packet arrives. Contexts are pooled and a suspended coroutine only
+// costs its context and a slot, so thousands of bots can sit in a scenario at the same time.
+class CoroutineScheduler
+{
+public:
+	// Called by the io threads
+	static void PostStart(u32 botId);
+	static void PostStop(u32 botId);
+
+	// Only opcodes some coroutine waits for are posted, so the check in the packet path is a single atomic load
+	inline static bool IsWaitingFor(u16 opcode)
+	{
+		return opcode < Common::NUM_MSG_TYPES && _opcodeWaiters[opcode].load(std::memory_order_relaxed) > 0;
+	}
+	static void PostOpcode(u32 botId, u16 opcode);
+
+	// Called by the tick thread
+	static void Update();
+	static void GetStatus(CoroutineStatus& status);
+
+	// Called by scripts from inside a scenario, they suspend the calling context
+	static void SuspendForTick();
+	static void SuspendFor(u32 milliseconds);
+	static void SuspendForOpcode(u16 opcode, u32 timeoutMilliseconds);
+	static bool TimedOut();
+
+private:
+	struct Coroutine
+	{
+		asIScriptContext* context = nullptr;
+		asIScriptFunction* function = nullptr;
+		u32 botId = 0;
+		// Bumped every time the coroutine suspends so timers and wakeups left over from an earlier wait are ignored
+		u32 waitId = 0;
+		CoroutineWait wait = COROUTINE_RUNNING;
+		u16 opcode = 0;
+		bool timedOut = false;
+	};
+
+	static void Start(asIScriptFunction* function, u32 botId);
+	static void Resume(u32 index);
+	static void Suspend(u32 index);
+	static void Release(u32 index);
+	static void Abort(u32 index);
+	static void StopWaiting(u32 index);
+	static void AbortRemovedScenarios();
+	static Coroutine* SuspendCurrent(char const* function);
+
+	inline static u64 MakeHandle(u32 index, u32 waitId) { return static_cast<u64>(index) | (static_cast<u64>(waitId) << 32); }
+	inline static u64 MakeWaitKey(u32 botId, u16 opcode) { return (static_cast<u64>(botId) << 16) | opcode; }
+	static bool IsCurrentWait(u64 handle, CoroutineWait wait);
+	static u64 GetTime();
+
+	static moodycamel::ConcurrentQueue<CoroutineEvent> _events;
+	static std::array<std::atomic<u32>, Common::NUM_MSG_TYPES> _opcodeWaiters;
+
+	static std::vector<Coroutine> _coroutines;
+	static std::vector<u32> _freeCoroutines;
+	static std::vector<asIScriptContext*> _contextPool;
+	// Per thread so hooks running on io threads never see the tick thread's coroutine and touch _coroutines
+	static thread_local u32 _current;
+
+	static std::vector<u64> _yielded;
+	static TimerWheel<u64> _timers;
+	static robin_hood::unordered_flat_map<u64, std::vector<u64>> _opcodeWaits;
+
+	static std::chrono::steady_clock::time_point _startTime;
+	static u64 _tableVersion;
+};
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "AngelBinder.h"
 
 #include "PacketHooks.h"
+#include "Coroutines.h"
 
 namespace GlobalFunctions
 {
@@ -12,6 +13,11 @@ namespace GlobalFunctions
 		PacketHooks::Register(static_cast<PacketHooks::Hooks>(callbackId), callback);
 	}
 
+	inline void RegisterBotScenario(asIScriptFunction* callback)
+	{
+		PacketHooks::RegisterScenario(callback);
+	}
+
 	inline void Print(std::string& message)
 	{
 		NC_LOG_MESSAGE("[Script]: %s", message.c_str());
@@ -24,6 +30,14 @@ void RegisterGlobalFunctions(AngelBinder::Engine* engine)
 	engine->asEngine()->RegisterFuncdef("void PacketCallback(string, uint8)");
 	engine->asEngine()->RegisterGlobalFunction("void RegisterPacketCallback(uint32 id, PacketCallback @cb)", asFUNCTION(GlobalFunctions::RegisterPacketCallback), asCALL_CDECL);
 
+	// Scenarios run as coroutines, one per bot that enters the world, and may suspend themselves with the functions below
+	engine->asEngine()->RegisterFuncdef("void BotScenario(uint botId)");
+	engine->asEngine()->RegisterGlobalFunction("void RegisterBotScenario(BotScenario @cb)", asFUNCTION(GlobalFunctions::RegisterBotScenario), asCALL_CDECL);
+	engine->asEngine()->RegisterGlobalFunction("void Yield()", asFUNCTION(CoroutineScheduler::SuspendForTick), asCALL_CDECL);
+	engine->asEngine()->RegisterGlobalFunction("void Sleep(uint milliseconds)", asFUNCTION(CoroutineScheduler::SuspendFor), asCALL_CDECL);
+	engine->asEngine()->RegisterGlobalFunction("void WaitForOpcode(uint16 opcode, uint timeoutMilliseconds)", asFUNCTION(CoroutineScheduler::SuspendForOpcode), asCALL_CDECL);
+	engine->asEngine()->RegisterGlobalFunction("bool TimedOut()", asFUNCTION(CoroutineScheduler::TimedOut), asCALL_CDECL);
+
 	AngelBinder::Exporter::Export(*engine)
 		[
 			AngelBinder::Exporter::Functions()
@@ -5,6 +5,8 @@
 
 #include "../Connection/NovusConnection.h"
 #include "ScriptEngine.h"
+#include "PacketHooks.h"
+#include "PacketView.h"
 
 namespace PacketFunctions
 {
@@ -12,11 +14,19 @@ namespace PacketFunctions
 	{
 		NC_LOG_MESSAGE("Send login!");
 		
-		NovusConnection* connection = new NovusConnection(new asio::ip::tcp::socket(*ScriptEngine::GetIOService()), ConfigHandler::GetOption<std::string>("address", "127.0.0.1"), ConfigHandler::GetOption<u16>("port", 3724));
+		// Script connections get ids from the top half so they don't collide with swarm bots in packet captures
+		static std::atomic<u32> nextConnectionId(0x80000000);
+
+		NovusConnection* connection = new NovusConnection(new asio::ip::tcp::socket(*ScriptEngine::GetIOService()), ConfigHandler::GetOption<std::string>("address", "127.0.0.1"), ConfigHandler::GetOption<u16>("port", 3724), nextConnectionId++);
 		connection->Start(username, password);
 		ScriptEngine::RegisterNovusConnection(connection);
 	}
 
+	inline void RegisterOpcodeCallback(u16 opcode, asIScriptFunction* callback)
+	{
+		PacketHooks::RegisterOpcode(opcode, callback);
+	}
+
 	inline void HelloWorld()
 	{
 		NC_LOG_MESSAGE("Hello World!");
@@ -25,6 +35,32 @@ namespace PacketFunctions
 
 void RegisterPacketFunctions(AngelBinder::Engine* engine)
 {
+	// PacketView and the opcode callback need to be registered manually since the binder does not support handles.
+	// Views point into the connection's receive buffer, so they are scoped: callbacks only get a reference for the duration
+	// of the call and scripts can't hold a handle to one or copy it. The factory only exists because scoped types have to
+	// be instantiable to be used as parameters, the views it creates are empty.
+	asIScriptEngine* scriptEngine = engine->asEngine();
+	scriptEngine->RegisterObjectType("PacketView", 0, asOBJ_REF | asOBJ_SCOPED);
+	scriptEngine->RegisterObjectBehaviour("PacketView", asBEHAVE_FACTORY, "PacketView@ f()", asFUNCTION(PacketView::CreateEmpty), asCALL_CDECL);
+	scriptEngine->RegisterObjectBehaviour("PacketView", asBEHAVE_RELEASE, "void f()", asMETHOD(PacketView, Release), asCALL_THISCALL);
+	scriptEngine->RegisterObjectMethod("PacketView", "uint16 GetOpcode() const", asMETHOD(PacketView, GetOpcode), asCALL_THISCALL);
+	scriptEngine->RegisterObjectMethod("PacketView", "uint GetSize() const", asMETHOD(PacketView, GetSize), asCALL_THISCALL);
+	scriptEngine->RegisterObjectMethod("PacketView", "uint GetReadPos() const", asMETHOD(PacketView, GetReadPos), asCALL_THISCALL);
+	scriptEngine->RegisterObjectMethod("PacketView", "uint GetRemaining() const", asMETHOD(PacketView, GetRemaining), asCALL_THISCALL);
+	scriptEngine->RegisterObjectMethod("PacketView", "bool HasOverflowed() const", asMETHOD(PacketView, HasOverflowed), asCALL_THISCALL);
+	scriptEngine->RegisterObjectMethod("PacketView", "void Skip(uint count)", asMETHOD(PacketView, Skip), asCALL_THISCALL);
+	scriptEngine->RegisterObjectMethod("PacketView", "uint8 ReadU8()", asMETHOD(PacketView, ReadU8), asCALL_THISCALL);
+	scriptEngine->RegisterObjectMethod("PacketView", "uint16 ReadU16()", asMETHOD(PacketView, ReadU16), asCALL_THISCALL);
+	scriptEngine->RegisterObjectMethod("PacketView", "uint ReadU32()", asMETHOD(PacketView, ReadU32), asCALL_THISCALL);
+	scriptEngine->RegisterObjectMethod("PacketView", "uint64 ReadU64()", asMETHOD(PacketView, ReadU64), asCALL_THISCALL);
+	scriptEngine->RegisterObjectMethod("PacketView", "int ReadI32()", asMETHOD(PacketView, ReadI32), asCALL_THISCALL);
+	scriptEngine->RegisterObjectMethod("PacketView", "float ReadF32()", asMETHOD(PacketView, ReadF32), asCALL_THISCALL);
+	scriptEngine->RegisterObjectMethod("PacketView", "uint64 ReadPackedGUID()", asMETHOD(PacketView, ReadPackedGUID), asCALL_THISCALL);
+	scriptEngine->RegisterObjectMethod("PacketView", "string ReadString()", asMETHOD(PacketView, ReadString), asCALL_THISCALL);
+
+	scriptEngine->RegisterFuncdef("void OpcodeCallback(uint botId, PacketView &in packet)");
+	scriptEngine->RegisterGlobalFunction("void RegisterOpcodeCallback(uint16 opcode, OpcodeCallback @cb)", asFUNCTION(PacketFunctions::RegisterOpcodeCallback), asCALL_CDECL);
+
 	engine->asEngine()->SetDefaultNamespace("Packet");
 	AngelBinder::Exporter::Export(*engine)
 		[
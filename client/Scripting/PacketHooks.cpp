@@ -1,4 +1,320 @@
 #pragma once
 #include "PacketHooks.h"
+#include <algorithm>
 
-std::array<std::vector<asIScriptFunction*>, PacketHooks::COUNT> PacketHooks::_hooks;
\ No newline at end of file
+// Defined ahead of the tables so it outlives them during static destruction
+std::mutex PacketHooks::_retiredMutex;
+std::vector<PacketHooks::HookTable const*> PacketHooks::_retiredTables;
+
+std::shared_ptr<PacketHooks::HookTable const> PacketHooks::_table = MakePublishedTable(new HookTable());
+std::atomic<u64> PacketHooks::_version(1);
+std::unique_ptr<PacketHooks::HookTable> PacketHooks::_pendingTable;
+
+thread_local std::shared_ptr<PacketHooks::HookTable const> PacketHooks::_threadTable;
+thread_local u64 PacketHooks::_threadVersion = 0;
+
+template <typename... Args>
+constexpr PacketHooks::Parameters MakeParameters(std::tuple<Args...>*)
+{
+	static_assert(sizeof...(Args) <= PacketHooks::MAX_HOOK_PARAMETERS, "Too many hook parameters");
+	return { static_cast<u32>(sizeof...(Args)), { PacketHookParameter<Args>::declaration... } };
+}
+
+template <size_t... Ids>
+constexpr std::array<PacketHooks::Parameters, PacketHooks::COUNT> MakeParameterTable(std::index_sequence<Ids...>)
+{
+	return { MakeParameters(static_cast<typename PacketHooks::Signature<static_cast<PacketHooks::Hooks>(Ids)>::Arguments*>(nullptr))... };
+}
+
+static constexpr std::array<PacketHooks::Parameters, PacketHooks::COUNT> HookParameters = MakeParameterTable(std::make_index_sequence<PacketHooks::COUNT>());
+
+std::shared_ptr<PacketHooks::HookTable const> PacketHooks::MakePublishedTable(HookTable* table)
+{
+	return std::shared_ptr<HookTable const>(table, [](HookTable const* table)
+	{
+		std::lock_guard<std::mutex> lock(_retiredMutex);
+		_retiredTables.push_back(table);
+	});
+}
+
+PacketHooks::HookTable::HookTable(HookTable const& other) : hooks(other.hooks), opcodeHooks(other.opcodeHooks), opcodeMask(other.opcodeMask), scenarios(other.scenarios)
+{
+	for (std::vector<Hook> const& idHooks : hooks)
+	{
+		for (Hook const& hook : idHooks)
+		{
+			hook.function->AddRef();
+		}
+	}
+
+	for (size_t opcode = 0; opcode < Common::NUM_MSG_TYPES; opcode++)
+	{
+		for (Hook const& hook : opcodeHooks[opcode])
+		{
+			hook.function->AddRef();
+		}
+	}
+
+	for (Hook const& hook : scenarios)
+	{
+		hook.function->AddRef();
+	}
+}
+
+PacketHooks::HookTable::~HookTable()
+{
+	for (std::vector<Hook> const& idHooks : hooks)
+	{
+		for (Hook const& hook : idHooks)
+		{
+			hook.function->Release();
+		}
+	}
+
+	for (size_t opcode = 0; opcode < Common::NUM_MSG_TYPES; opcode++)
+	{
+		for (Hook const& hook : opcodeHooks[opcode])
+		{
+			hook.function->Release();
+		}
+	}
+
+	for (Hook const& hook : scenarios)
+	{
+		hook.function->Release();
+	}
+}
+
+void PacketHooks::BeginUpdate()
+{
+	std::vector<HookTable const*> retiredTables;
+	{
+		std::lock_guard<std::mutex> lock(_retiredMutex);
+		retiredTables.swap(_retiredTables);
+	}
+
+	for (HookTable const* table : retiredTables)
+	{
+		delete table;
+	}
+
+	_pendingTable = std::make_unique<HookTable>(*std::atomic_load(&_table));
+}
+
+void PacketHooks::RemoveModuleHooks(std::string const& module)
+{
+	auto isFromModule = [&module](Hook const& hook)
+	{
+		if (hook.module != module)
+			return false;
+
+		hook.function->Release();
+		return true;
+	};
+
+	for (std::vector<Hook>& hooks : _pendingTable->hooks)
+	{
+		hooks.erase(std::remove_if(hooks.begin(), hooks.end(), isFromModule), hooks.end());
+	}
+
+	for (size_t opcode = 0; opcode < Common::NUM_MSG_TYPES; opcode++)
+	{
+		if (!_pendingTable->opcodeMask[opcode])
+			continue;
+
+		std::vector<Hook>& hooks = _pendingTable->opcodeHooks[opcode];
+		hooks.erase(std::remove_if(hooks.begin(), hooks.end(), isFromModule), hooks.end());
+		_pendingTable->opcodeMask[opcode] = !hooks.empty();
+	}
+
+	std::vector<Hook>& scenarios = _pendingTable->scenarios;
+	scenarios.erase(std::remove_if(scenarios.begin(), scenarios.end(), isFromModule), scenarios.end());
+}
+
+void PacketHooks::RestoreModuleHooks(std::string const& module)
+{
+	RemoveModuleHooks(module);
+
+	// The published table is still the one from before the update so it has the hooks the module had
+	std::shared_ptr<HookTable const> table = std::atomic_load(&_table);
+	for (size_t id = 0; id < Hooks::COUNT; id++)
+	{
+		for (Hook const& hook : table->hooks[id])
+		{
+			if (hook.module == module)
+			{
+				hook.function->AddRef();
+				_pendingTable->hooks[id].push_back(hook);
+			}
+		}
+	}
+
+	for (size_t opcode = 0; opcode < Common::NUM_MSG_TYPES; opcode++)
+	{
+		for (Hook const& hook : table->opcodeHooks[opcode])
+		{
+			if (hook.module == module)
+			{
+				hook.function->AddRef();
+				_pendingTable->opcodeHooks[opcode].push_back(hook);
+				_pendingTable->opcodeMask.set(opcode);
+			}
+		}
+	}
+
+	for (Hook const& hook : table->scenarios)
+	{
+		if (hook.module == module)
+		{
+			hook.function->AddRef();
+			_pendingTable->scenarios.push_back(hook);
+		}
+	}
+}
+
+void PacketHooks::CommitUpdate()
+{
+	std::atomic_store(&_table, MakePublishedTable(_pendingTable.release()));
+	_version.fetch_add(1, std::memory_order_release);
+}
+
+void PacketHooks::RefreshTable()
+{
+	_threadVersion = _version.load(std::memory_order_acquire);
+	_threadTable = std::atomic_load(&_table);
+}
+
+void PacketHooks::AddHook(std::vector<Hook>& hooks, asIScriptFunction* func)
+{
+	char const* module = func->GetModuleName();
+	hooks.push_back({ func, ScriptEngine::GetScriptEngine(), module ? module : "" });
+}
+
+bool PacketHooks::Register(Hooks id, asIScriptFunction* func)
+{
+	if (!_pendingTable)
+	{
+		NC_LOG_ERROR("Callback '%s' can only be registered while scripts are loading", func->GetName());
+		func->Release();
+		return false;
+	}
+
+	if (id >= Hooks::COUNT)
+	{
+		NC_LOG_ERROR("Tried to register callback '%s' for unknown hook %u", func->GetName(), static_cast<u32>(id));
+		func->Release();
+		return false;
+	}
+
+	Parameters const& parameters = HookParameters[id];
+	if (func->GetParamCount() != parameters.count)
+	{
+		NC_LOG_ERROR("Callback '%s' takes %u arguments but hook %u passes %u", func->GetName(), func->GetParamCount(), static_cast<u32>(id), parameters.count);
+		func->Release();
+		return false;
+	}
+
+	asIScriptEngine* engine = func->GetEngine();
+	for (u32 i = 0; i < parameters.count; i++)
+	{
+		int paramTypeId;
+		func->GetParam(i, &paramTypeId);
+
+		if (paramTypeId != engine->GetTypeIdByDecl(parameters.declarations[i]))
+		{
+			NC_LOG_ERROR("Callback '%s' argument %u expects type %s but hook %u passes %s", func->GetName(), i, engine->GetTypeDeclaration(paramTypeId), static_cast<u32>(id), parameters.declarations[i]);
+			func->Release();
+			return false;
+		}
+	}
+
+	AddHook(_pendingTable->hooks[id], func);
+	return true;
+}
+
+bool PacketHooks::RegisterOpcode(u16 opcode, asIScriptFunction* func)
+{
+	if (!_pendingTable)
+	{
+		NC_LOG_ERROR("Callback '%s' can only be registered while scripts are loading", func->GetName());
+		func->Release();
+		return false;
+	}
+
+	if (opcode >= Common::NUM_MSG_TYPES)
+	{
+		NC_LOG_ERROR("Tried to register callback '%s' for unknown opcode 0x%04X", func->GetName(), static_cast<u32>(opcode));
+		func->Release();
+		return false;
+	}
+
+	AddHook(_pendingTable->opcodeHooks[opcode], func);
+	_pendingTable->opcodeMask.set(opcode);
+	return true;
+}
+
+bool PacketHooks::RegisterScenario(asIScriptFunction* func)
+{
+	if (!_pendingTable)
+	{
+		NC_LOG_ERROR("Scenario '%s' can only be registered while scripts are loading", func->GetName());
+		func->Release();
+		return false;
+	}
+
+	AddHook(_pendingTable->scenarios, func);
+	return true;
+}
+
+void PacketHooks::CallOpcodeHooks(u32 botId, PacketView& packet)
+{
+	for (Hook const& hook : GetTable().opcodeHooks[packet.GetOpcode()])
+	{
+		HookContext context(hook.engine);
+		if (context)
+		{
+			// Every hook gets to read the packet from the start
+			packet.Reset();
+
+			context->prepare(hook.function);
+			context->setDWord(botId);
+			context->setObject(&packet);
+
+			ScriptProfiler::Scope scope(context->asContext(), "Opcode", packet.GetOpcode());
+			context->execute();
+		}
+	}
+}
+
+PacketHooks::HookContext::HookContext(AngelBinder::Engine* engine) : _context(GetContext(engine)), _pooled(false)
+{
+	// Preparing the cached context while it runs would throw away the execution that is calling us
+	if (_context && _context->asContext()->GetState() == asEXECUTION_ACTIVE)
+	{
+		_context = engine->getContext();
+		_pooled = true;
+	}
+}
+
+PacketHooks::HookContext::~HookContext()
+{
+	if (_pooled && _context)
+		_context->release();
+}
+
+AngelBinder::Context* PacketHooks::GetContext(AngelBinder::Engine* engine)
+{
+	thread_local AngelBinder::Engine* contextEngine = nullptr;
+	thread_local AngelBinder::Context* context = nullptr;
+
+	if (contextEngine != engine)
+	{
+		if (context)
+			context->release();
+
+		context = engine->getContext();
+		contextEngine = engine;
+	}
+
+	return context;
+}
\ No newline at end of file
@@ -1,10 +1,32 @@
 #pragma once
 #include "../Utils/DebugHandler.h"
-#include "../Utils/Any.h"
+#include "../Networking/Opcode/Opcode.h"
 #include "ScriptEngine.h"
 #include "AngelBinder.h"
+#include "PacketView.h"
+#include "ScriptProfiler.h"
 #include <array>
+#include <atomic>
+#include <bitset>
 #include <memory>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+
+// Maps a C++ hook argument type to the AngelScript declaration a callback parameter needs to have
+template <typename T>
+struct PacketHookParameter;
+
+template <> struct PacketHookParameter<bool> { static constexpr char const* declaration = "bool"; };
+template <> struct PacketHookParameter<u8> { static constexpr char const* declaration = "uint8"; };
+template <> struct PacketHookParameter<u16> { static constexpr char const* declaration = "uint16"; };
+template <> struct PacketHookParameter<u32> { static constexpr char const* declaration = "uint"; };
+template <> struct PacketHookParameter<i8> { static constexpr char const* declaration = "int8"; };
+template <> struct PacketHookParameter<i16> { static constexpr char const* declaration = "int16"; };
+template <> struct PacketHookParameter<i32> { static constexpr char const* declaration = "int"; };
+template <> struct PacketHookParameter<f32> { static constexpr char const* declaration = "float"; };
+template <> struct PacketHookParameter<f64> { static constexpr char const* declaration = "double"; };
+template <> struct PacketHookParameter<std::string> { static constexpr char const* declaration = "string"; };
 
 class PacketHooks
 {
@@ -16,80 +38,141 @@ public:
 		COUNT
 	};
 
-	inline static void Register(Hooks id, asIScriptFunction* func)
+	static constexpr u32 MAX_HOOK_PARAMETERS = 8;
+
+	// Every hook declares its name and the arguments it is called with, see the specializations below the class
+	template <Hooks id>
+	struct Signature;
+
+	struct Parameters
+	{
+		u32 count;
+		char const* declarations[MAX_HOOK_PARAMETERS];
+	};
+
+	struct Hook
+	{
+		asIScriptFunction* function;
+		// The engine that compiled the function, its contexts are the only ones allowed to execute it
+		AngelBinder::Engine* engine;
+		// Lets a reload drop exactly the hooks a rebuilt module registered
+		std::string module;
+	};
+
+	// Every hook that is active at one point in time. Published tables are never modified, a reload builds a copy and swaps
+	// it in as a whole so bots never see a partially reloaded set of hooks. A table holds a reference to each hooked function.
+	struct HookTable
 	{
-		_hooks[id].push_back(func);
+		HookTable() = default;
+		HookTable(HookTable const& other);
+		HookTable& operator=(HookTable const& other) = delete;
+		~HookTable();
+
+		std::array<std::vector<Hook>, Hooks::COUNT> hooks;
+		std::array<std::vector<Hook>, Common::NUM_MSG_TYPES> opcodeHooks;
+		std::bitset<Common::NUM_MSG_TYPES> opcodeMask;
+		// Started as a coroutine for every bot that enters the world
+		std::vector<Hook> scenarios;
+	};
+
+	// Registration only happens while scripts are being loaded, into the table that will be published next
+	static void BeginUpdate();
+	static void RemoveModuleHooks(std::string const& module);
+	// Puts back the hooks the published table has for a module, used when rebuilding that module failed
+	static void RestoreModuleHooks(std::string const& module);
+	static void CommitUpdate();
+
+	// Checks the callback against the hook signature once so calling it never has to, returns false and releases the callback on a mismatch
+	static bool Register(Hooks id, asIScriptFunction* func);
+
+	// Opcode hooks fire for every world packet with that opcode, the callback signature is enforced by the OpcodeCallback funcdef
+	static bool RegisterOpcode(u16 opcode, asIScriptFunction* func);
+	static bool RegisterScenario(asIScriptFunction* func);
+
+	// Each thread holds on to the table it last saw and only goes to the shared one after an update was published,
+	// so looking up hooks is a single atomic load in the common case
+	inline static HookTable const& GetTable()
+	{
+		if (_threadVersion != _version.load(std::memory_order_acquire))
+			RefreshTable();
+
+		return *_threadTable;
 	}
 
-	inline static std::vector<asIScriptFunction*>& GetHooks(Hooks id)
+	// Bumped every time a new table is published
+	inline static u64 GetVersion()
 	{
-		return _hooks[id];
+		return _version.load(std::memory_order_acquire);
 	}
 
-	template <typename... Args>
-	inline static void CallHook(Hooks id, Args... args)
+	// Checked before building a view so opcodes nobody hooked cost a single bit test
+	inline static bool HasOpcodeHooks(u16 opcode)
 	{
-		for (auto function : _hooks[id])
-		{
-			AngelBinder::Context* context = ScriptEngine::GetScriptContext();
-			if (context)
-			{
-				context->prepare(function);
-
-				std::vector<any> arguments = { args... };
-
-				assert(arguments.size() == function->GetParamCount());
-
-				int i = 0;
-				for (auto argument : arguments)
-				{
-					int paramTypeId;
-					function->GetParam(i++, &paramTypeId);
-					size_t argTypeId = argument.get_type();
-
-					if (paramTypeId != argTypeId)
-					{
-						NC_LOG_FATAL("When trying to call function '%s', argument %u expects type %s but gets type %s", function->GetName(), i, any::GetTypeName(paramTypeId), any::GetTypeName(argTypeId));
-					}
-
-					assert(paramTypeId == argTypeId);
-
-					switch (argTypeId)
-					{
-						case any::U8: context->setByte(argument.get_u8()); break;
-						case any::U16: context->setWord(argument.get_u16()); break;
-						case any::U32: context->setDWord(argument.get_u32()); break;
-						case any::U64: context->setQWord(argument.get_u64()); break;
-						case any::I8: context->setByte(argument.get_i8()); break;
-						case any::I16: context->setWord(argument.get_i16()); break;
-						case any::I32: context->setDWord(argument.get_i32()); break;
-						case any::I64: context->setQWord(argument.get_i64()); break;
-						case any::F32: context->setFloat(argument.get_f32()); break;
-						case any::F64: context->setDouble(argument.get_f64()); break;
-						case any::Bool: context->setBool(argument.get_bool()); break;
-						case any::String: context->setObject(&argument.get_string()); break;
-					}
-				}
-				
-				context->execute();
-				context->release();
-			}
-		}
-		return;
+		return opcode < Common::NUM_MSG_TYPES && GetTable().opcodeMask[opcode];
 	}
 
-	inline static void ClearHooks()
+	static void CallOpcodeHooks(u32 botId, PacketView& packet);
+
+	template <Hooks id, typename... Args>
+	inline static void CallHook(Args const&... args)
 	{
-		for (size_t i = 0; i < Hooks::COUNT; i++)
+		static_assert(std::is_same<typename Signature<id>::Arguments, std::tuple<std::decay_t<Args>...>>::value, "Hook arguments do not match the hook signature");
+
+		for (Hook const& hook : GetTable().hooks[id])
 		{
-			for (auto function : _hooks[i])
+			HookContext context(hook.engine);
+			if (context)
 			{
-				function->Release();
+				context->prepare(hook.function);
+				(AngelBinder::ParameterSetter<Args>()(context.Get(), const_cast<Args&>(args)), ...);
+
+				ScriptProfiler::Scope scope(context->asContext(), Signature<id>::name);
+				context->execute();
 			}
-			_hooks[i].clear();
 		}
 	}
 
 private:
-	static std::array<std::vector<asIScriptFunction*>, Hooks::COUNT> _hooks;
+	// Each thread keeps one context around instead of going through the pool for every call. A hook called while that
+	// context is still executing, from inside another hook, gets its own context from the pool for the nested call.
+	class HookContext
+	{
+	public:
+		HookContext(AngelBinder::Engine* engine);
+		~HookContext();
+
+		HookContext(HookContext const&) = delete;
+		HookContext& operator=(HookContext const&) = delete;
+
+		explicit operator bool() const { return _context != nullptr; }
+		AngelBinder::Context* operator->() const { return _context; }
+		AngelBinder::Context* Get() const { return _context; }
+
+	private:
+		AngelBinder::Context* _context;
+		bool _pooled;
+	};
+
+	static AngelBinder::Context* GetContext(AngelBinder::Engine* engine);
+	static void RefreshTable();
+	static std::shared_ptr<HookTable const> MakePublishedTable(HookTable* table);
+	static void AddHook(std::vector<Hook>& hooks, asIScriptFunction* func);
+
+	static std::shared_ptr<HookTable const> _table;
+	static std::atomic<u64> _version;
+	static std::unique_ptr<HookTable> _pendingTable;
+
+	static thread_local std::shared_ptr<HookTable const> _threadTable;
+	static thread_local u64 _threadVersion;
+
+	// Old tables are released on the loading thread since releasing the last reference to a function can touch the engine
+	static std::mutex _retiredMutex;
+	static std::vector<HookTable const*> _retiredTables;
+};
+
+template <>
+struct PacketHooks::Signature<PacketHooks::HOOK_ONLOGIN_CHALLENGE>
+{
+	static constexpr char const* name = "OnLoginChallenge";
+	typedef std::tuple<std::string, u8> Arguments;
 };
\ No newline at end of file
@@ -0,0 +1,114 @@
+#pragma once
+#include "../NovusTypes.h"
+#include <cstring>
+#include <string>
+
+// Read only view over a packet body that still lives in the connection's receive buffer. Opcode hooks get one of these
+// so scripts can parse packets without them being copied, which also means it is only valid during the hook call.
+// Reading past the end returns zeroes and marks the view as overflowed instead of throwing inside the script.
+class PacketView
+{
+public:
+	PacketView(u16 opcode, u8 const* data, size_t size) : _opcode(opcode), _data(data), _size(size), _readPos(0), _overflowed(false), _scriptOwned(false) { }
+
+	// Views created by scripts are empty and freed once the script is done with them, views handed to hooks belong to
+	// the connection and releasing them does nothing
+	static PacketView* CreateEmpty()
+	{
+		PacketView* view = new PacketView(0, nullptr, 0);
+		view->_scriptOwned = true;
+		return view;
+	}
+	void Release()
+	{
+		if (_scriptOwned)
+			delete this;
+	}
+
+	u16 GetOpcode() const { return _opcode; }
+	u32 GetSize() const { return static_cast<u32>(_size); }
+	u32 GetReadPos() const { return static_cast<u32>(_readPos); }
+	u32 GetRemaining() const { return static_cast<u32>(_size - _readPos); }
+	bool HasOverflowed() const { return _overflowed; }
+
+	void Reset()
+	{
+		_readPos = 0;
+		_overflowed = false;
+	}
+	void Skip(u32 count)
+	{
+		if (CanRead(count))
+			_readPos += count;
+	}
+
+	u8 ReadU8() { return Read<u8>(); }
+	u16 ReadU16() { return Read<u16>(); }
+	u32 ReadU32() { return Read<u32>(); }
+	u64 ReadU64() { return Read<u64>(); }
+	i32 ReadI32() { return Read<i32>(); }
+	f32 ReadF32() { return Read<f32>(); }
+
+	u64 ReadPackedGUID()
+	{
+		u64 guid = 0;
+		u8 guidMark = ReadU8();
+
+		for (u32 i = 0; i < 8; i++)
+		{
+			if (guidMark & (u8(1) << i))
+				guid |= u64(ReadU8()) << (i * 8);
+		}
+
+		return guid;
+	}
+
+	std::string ReadString()
+	{
+		if (!CanRead(1))
+			return std::string();
+
+		u8 const* start = _data + _readPos;
+		u8 const* end = static_cast<u8 const*>(std::memchr(start, 0, _size - _readPos));
+		if (!end)
+		{
+			// Unterminated, hand out what is left
+			_overflowed = true;
+			_readPos = _size;
+			return std::string(reinterpret_cast<char const*>(start), _data + _size - start);
+		}
+
+		_readPos += (end - start) + 1;
+		return std::string(reinterpret_cast<char const*>(start), end - start);
+	}
+
+private:
+	template <typename T>
+	T Read()
+	{
+		T value = 0;
+		if (CanRead(sizeof(T)))
+		{
+			std::memcpy(&value, _data + _readPos, sizeof(T));
+			_readPos += sizeof(T);
+		}
+		return value;
+	}
+
+	bool CanRead(size_t count)
+	{
+		if (_size - _readPos >= count)
+			return true;
+
+		_overflowed = true;
+		_readPos = _size;
+		return false;
+	}
+
+	u16 _opcode;
+	u8 const* _data;
+	size_t _size;
+	size_t _readPos;
+	bool _overflowed;
+	bool _scriptOwned;
+};
\ No newline at end of file
@@ -0,0 +1,311 @@
+#include "ScriptCache.h"
+#include "../Utils/DebugHandler.h"
+#include "../Cryptography/SHA1.h"
+#include "AngelBinder.h"
+#include "Addons/scriptbuilder/scriptbuilder.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+constexpr u32 SCRIPT_CACHE_MAGIC = 0x4253434E; // NCSB
+constexpr u32 SCRIPT_CACHE_VERSION = 1;
+
+#pragma pack(push, 1)
+struct ScriptCacheHeader
+{
+	u32 magic;
+	u32 version;
+	u8 fingerprint[SHA_DIGEST_LENGTH];
+	u32 sectionCount;
+};
+#pragma pack(pop)
+
+// Appends everything AngelScript writes to a plain byte vector
+class ScriptCacheWriter : public asIBinaryStream
+{
+public:
+	ScriptCacheWriter(std::vector<u8>& data) : _data(data) { }
+
+	int Read(void*, asUINT) override { return asNOT_SUPPORTED; }
+	int Write(const void* ptr, asUINT size) override
+	{
+		u8 const* bytes = static_cast<u8 const*>(ptr);
+		_data.insert(_data.end(), bytes, bytes + size);
+		return 0;
+	}
+
+private:
+	std::vector<u8>& _data;
+};
+
+// Bounds checked reads over a loaded cache entry so a truncated file fails the load instead of reading past the end
+class ScriptCacheReader : public asIBinaryStream
+{
+public:
+	ScriptCacheReader(u8 const* data, size_t size) : _data(data), _size(size), _readPos(0) { }
+
+	int Read(void* ptr, asUINT size) override
+	{
+		if (_size - _readPos < size)
+			return asERROR;
+
+		std::memcpy(ptr, _data + _readPos, size);
+		_readPos += size;
+		return 0;
+	}
+	int Write(const void*, asUINT) override { return asNOT_SUPPORTED; }
+
+	size_t GetReadPos() const { return _readPos; }
+
+private:
+	u8 const* _data;
+	size_t _size;
+	size_t _readPos;
+};
+
+fs::path ScriptCache::_directory;
+asIScriptEngine* ScriptCache::_fingerprintEngine = nullptr;
+ScriptHash ScriptCache::_fingerprint;
+
+void ScriptCache::SetDirectory(std::string const& directory)
+{
+	_directory.clear();
+	if (directory.empty())
+		return;
+
+	std::error_code error;
+	fs::create_directories(directory, error);
+	if (error)
+	{
+		NC_LOG_WARNING("Script cache disabled, could not create %s: %s", directory.c_str(), error.message().c_str());
+		return;
+	}
+
+	_directory = fs::absolute(directory);
+}
+
+fs::path ScriptCache::GetEntryPath(fs::path const& path)
+{
+	// Entries are named after the script path so scripts with the same filename in different folders don't collide
+	SHA1Hasher sha;
+	sha.UpdateHash(fs::absolute(path).string());
+	sha.Finish();
+
+	char name[2 * 8 + 1];
+	for (u32 i = 0; i < 8; i++)
+		snprintf(&name[i * 2], 3, "%02x", sha.GetData()[i]);
+
+	return _directory / (std::string(name) + ".ncsb");
+}
+
+bool ScriptCache::HashFile(std::string const& path, ScriptHash& hash)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	HashSource(contents, hash);
+	return true;
+}
+
+void ScriptCache::HashSource(std::string const& source, ScriptHash& hash)
+{
+	SHA1Hasher sha;
+	sha.UpdateHash(source);
+	sha.Finish();
+	std::memcpy(hash.data(), sha.GetData(), hash.size());
+}
+
+ScriptHash const& ScriptCache::GetFingerprint(asIScriptEngine* engine)
+{
+	if (_fingerprintEngine == engine)
+		return _fingerprint;
+
+	// Bytecode refers to the application API by declaration, so any registered declaration changing invalidates every entry
+	SHA1Hasher sha;
+	sha.UpdateHash(ANGELSCRIPT_VERSION_STRING);
+
+	for (asUINT i = 0; i < engine->GetGlobalFunctionCount(); i++)
+		sha.UpdateHash(engine->GetGlobalFunctionByIndex(i)->GetDeclaration(true, true, true));
+
+	for (asUINT i = 0; i < engine->GetGlobalPropertyCount(); i++)
+	{
+		char const* name;
+		char const* nameSpace;
+		int typeId;
+		engine->GetGlobalPropertyByIndex(i, &name, &nameSpace, &typeId);
+		sha.UpdateHash(std::string(nameSpace) + "::" + name + " " + engine->GetTypeDeclaration(typeId, true));
+	}
+
+	for (asUINT i = 0; i < engine->GetObjectTypeCount(); i++)
+	{
+		asITypeInfo* type = engine->GetObjectTypeByIndex(i);
+		sha.UpdateHash(std::string(type->GetNamespace()) + "::" + type->GetName());
+		asDWORD flags = type->GetFlags();
+		sha.UpdateHash(reinterpret_cast<u8 const*>(&flags), sizeof(flags));
+
+		for (asUINT j = 0; j < type->GetFactoryCount(); j++)
+			sha.UpdateHash(type->GetFactoryByIndex(j)->GetDeclaration(true, true, true));
+
+		for (asUINT j = 0; j < type->GetBehaviourCount(); j++)
+			sha.UpdateHash(type->GetBehaviourByIndex(j, nullptr)->GetDeclaration(true, true, true));
+
+		for (asUINT j = 0; j < type->GetMethodCount(); j++)
+			sha.UpdateHash(type->GetMethodByIndex(j)->GetDeclaration(true, true, true));
+
+		for (asUINT j = 0; j < type->GetPropertyCount(); j++)
+			sha.UpdateHash(type->GetPropertyDeclaration(j, true));
+	}
+
+	for (asUINT i = 0; i < engine->GetEnumCount(); i++)
+	{
+		asITypeInfo* type = engine->GetEnumByIndex(i);
+		sha.UpdateHash(std::string(type->GetNamespace()) + "::" + type->GetName());
+
+		for (asUINT j = 0; j < type->GetEnumValueCount(); j++)
+		{
+			int value;
+			sha.UpdateHash(type->GetEnumValueByIndex(j, &value));
+			sha.UpdateHash(reinterpret_cast<u8 const*>(&value), sizeof(value));
+		}
+	}
+
+	for (asUINT i = 0; i < engine->GetFuncdefCount(); i++)
+		sha.UpdateHash(engine->GetFuncdefByIndex(i)->GetFuncdefSignature()->GetDeclaration(true, true, true));
+
+	for (asUINT i = 0; i < engine->GetTypedefCount(); i++)
+	{
+		asITypeInfo* type = engine->GetTypedefByIndex(i);
+		sha.UpdateHash(std::string(type->GetNamespace()) + "::" + type->GetName() + " " + engine->GetTypeDeclaration(type->GetTypedefTypeId(), true));
+	}
+
+	sha.Finish();
+	std::memcpy(_fingerprint.data(), sha.GetData(), _fingerprint.size());
+	_fingerprintEngine = engine;
+
+	return _fingerprint;
+}
+
+bool ScriptCache::ReadEntry(fs::path const& path, ScriptHash const& fingerprint, std::vector<u8>& entry, size_t& byteCodeOffset, std::vector<ScriptSection>& sections)
+{
+	if (!IsEnabled())
+		return false;
+
+	std::ifstream file(GetEntryPath(path), std::ios::binary);
+	if (!file)
+		return false;
+
+	entry.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	ScriptCacheReader reader(entry.data(), entry.size());
+
+	ScriptCacheHeader header;
+	if (reader.Read(&header, sizeof(header)) < 0 || header.magic != SCRIPT_CACHE_MAGIC || header.version != SCRIPT_CACHE_VERSION)
+		return false;
+
+	if (std::memcmp(header.fingerprint, fingerprint.data(), SHA_DIGEST_LENGTH) != 0)
+		return false;
+
+	// Every section the module was built from has to be unchanged, includes as well as the script itself
+	for (u32 i = 0; i < header.sectionCount; i++)
+	{
+		u16 nameLength;
+		if (reader.Read(&nameLength, sizeof(nameLength)) < 0)
+			return false;
+
+		std::string sectionName(nameLength, '\0');
+		ScriptHash cachedHash;
+		if (reader.Read(&sectionName[0], nameLength) < 0 || reader.Read(cachedHash.data(), static_cast<asUINT>(cachedHash.size())) < 0)
+			return false;
+
+		ScriptHash hash;
+		if (!HashFile(sectionName, hash) || hash != cachedHash)
+		{
+			sections.clear();
+			return false;
+		}
+
+		sections.push_back({ sectionName, "", hash });
+	}
+
+	byteCodeOffset = reader.GetReadPos();
+	return true;
+}
+
+bool ScriptCache::LoadEntry(asIScriptEngine* engine, std::string const& moduleName, std::vector<u8> const& entry, size_t byteCodeOffset)
+{
+	ScriptCacheReader reader(entry.data() + byteCodeOffset, entry.size() - byteCodeOffset);
+
+	asIScriptModule* module = engine->GetModule(moduleName.c_str(), asGM_ALWAYS_CREATE);
+	if (module->LoadByteCode(&reader) < 0)
+	{
+		NC_LOG_WARNING("[Script]: Discarding unreadable cache entry for %s", moduleName.c_str());
+		module->Discard();
+		return false;
+	}
+
+	return true;
+}
+
+void ScriptCache::Save(asIScriptModule* module, CScriptBuilder const& builder, fs::path const& path, std::vector<ScriptSection> const& sections)
+{
+	if (!IsEnabled())
+		return;
+
+	std::vector<u8> data(sizeof(ScriptCacheHeader));
+	ScriptCacheWriter writer(data);
+
+	ScriptCacheHeader header;
+	header.magic = SCRIPT_CACHE_MAGIC;
+	header.version = SCRIPT_CACHE_VERSION;
+	std::memcpy(header.fingerprint, GetFingerprint(module->GetEngine()).data(), SHA_DIGEST_LENGTH);
+	header.sectionCount = builder.GetSectionCount();
+
+	for (u32 i = 0; i < header.sectionCount; i++)
+	{
+		std::string sectionName = builder.GetSectionName(i);
+
+		ScriptHash hash;
+		auto section = std::find_if(sections.begin(), sections.end(), [&sectionName](ScriptSection const& section) { return section.name == sectionName; });
+		if (section != sections.end())
+		{
+			hash = section->hash;
+		}
+		else if (!HashFile(sectionName, hash))
+		{
+			return;
+		}
+
+		u16 nameLength = static_cast<u16>(sectionName.size());
+		writer.Write(&nameLength, sizeof(nameLength));
+		writer.Write(sectionName.data(), nameLength);
+		writer.Write(hash.data(), static_cast<asUINT>(hash.size()));
+	}
+
+	// Debug info is kept so errors and profiles still point at script lines
+	if (module->SaveByteCode(&writer, false) < 0)
+		return;
+
+	std::memcpy(data.data(), &header, sizeof(header));
+
+	// Written next to the entry and moved over it so a reader never sees half an entry
+	fs::path entryPath = GetEntryPath(path);
+	fs::path tempPath = entryPath;
+	tempPath += ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.write(reinterpret_cast<char const*>(data.data()), data.size()))
+			return;
+	}
+
+	std::error_code error;
+	fs::rename(tempPath, entryPath, error);
+	if (error)
+	{
+		NC_LOG_WARNING("[Script]: Could not write cache entry for %s: %s", path.string().c_str(), error.message().c_str());
+	}
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+#include "../NovusTypes.h"
+#include <array>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <openssl/sha.h>
+
+class asIScriptEngine;
+class asIScriptModule;
+class CScriptBuilder;
+
+typedef std::array<u8, SHA_DIGEST_LENGTH> ScriptHash;
+
+// A script file, or a file it includes, read into memory ahead of building it
+struct ScriptSection
+{
+	std::string name;
+	std::string source;
+	ScriptHash hash;
+};
+
+// Keeps compiled script modules around as AngelScript bytecode so unchanged scripts skip parsing and compiling entirely.
+// A cache entry remembers the hash of every section the module was built from, the script itself and everything it
+// included, together with a fingerprint of the registered API, and is only used while all of them still match.
+class ScriptCache
+{
+public:
+	static void SetDirectory(std::string const& directory);
+	static bool IsEnabled() { return !_directory.empty(); }
+
+	// Has to be called from the loading thread before any entries are read
+	static ScriptHash const& GetFingerprint(asIScriptEngine* engine);
+	static void HashSource(std::string const& source, ScriptHash& hash);
+
+	// Reads and validates the entry for a script without touching the engine, safe to call from any thread
+	static bool ReadEntry(std::filesystem::path const& path, ScriptHash const& fingerprint, std::vector<u8>& entry, size_t& byteCodeOffset, std::vector<ScriptSection>& sections);
+	// Creates the module from an entry ReadEntry accepted, returns false if the bytecode turned out to be unusable
+	static bool LoadEntry(asIScriptEngine* engine, std::string const& moduleName, std::vector<u8> const& entry, size_t byteCodeOffset);
+	// Sections the builder pulled in that aren't in the given list are hashed from disk
+	static void Save(asIScriptModule* module, CScriptBuilder const& builder, std::filesystem::path const& path, std::vector<ScriptSection> const& sections);
+
+private:
+	static std::filesystem::path GetEntryPath(std::filesystem::path const& path);
+	static bool HashFile(std::string const& path, ScriptHash& hash);
+
+	ScriptCache();
+private:
+	static std::filesystem::path _directory;
+	static asIScriptEngine* _fingerprintEngine;
+	static ScriptHash _fingerprint;
+};
\ No newline at end of file
@@ -11,6 +11,8 @@
 #include "Addons/scriptstdstring/scriptstdstring.h"
 
 #include "ScriptEngine.h"
+#include "ScriptCache.h"
+#include "ScriptProfiler.h"
 
 // NovusCore functions
 #include "GlobalFunctions.h"
@@ -19,20 +21,117 @@
 // NovusCore hooks
 #include "PacketHooks.h"
 
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
 namespace fs = std::filesystem;
 
 std::string ScriptHandler::_path = "";
+std::string ScriptHandler::_loadTimesPath = "";
 asio::io_service* ScriptHandler::_ioService = nullptr;
 
+robin_hood::unordered_node_map<std::string, ScriptHandler::LoadedScript> ScriptHandler::_scripts;
+
 void ScriptHandler::ReloadScripts()
 {
+	if (_path == "")
+		return;
+
 	NC_LOG_MESSAGE("Reloading scripts...");
-	PacketHooks::ClearHooks();
 
-	if (_path != "")
+	Timer timer;
+	std::vector<ScriptLoadTask> tasks;
+	size_t unchangedCount = 0;
+	for (auto& script : _scripts)
+	{
+		script.second.seen = false;
+	}
+
+	// Scripts whose sections all kept their write time are skipped without being read
+	for (auto& p : fs::recursive_directory_iterator(fs::absolute(_path)))
+	{
+		if (p.is_directory())
+			continue;
+
+		auto script = _scripts.find(NormalizePath(p.path()));
+		if (script != _scripts.end())
+		{
+			script->second.seen = true;
+			if (!IsModified(script->second))
+			{
+				unchangedCount++;
+				continue;
+			}
+		}
+
+		ScriptLoadTask& task = tasks.emplace_back();
+		task.path = p.path();
+		task.moduleName = p.path().filename().string();
+	}
+
+	PrepareScripts(tasks);
+
+	// Touched but identical scripts only need their write times updated
+	auto isUnchanged = [&unchangedCount](ScriptLoadTask& task)
+	{
+		auto script = _scripts.find(NormalizePath(task.path));
+		if (script == _scripts.end() || !HasSameSections(script->second, task.sections))
+			return false;
+
+		RecordScript(task);
+		unchangedCount++;
+		return true;
+	};
+	tasks.erase(std::remove_if(tasks.begin(), tasks.end(), isUnchanged), tasks.end());
+
+	std::vector<std::string> removedScripts;
+	for (auto& script : _scripts)
+	{
+		if (!script.second.seen)
+			removedScripts.push_back(script.first);
+	}
+
+	if (tasks.empty() && removedScripts.empty())
+	{
+		NC_LOG_SUCCESS("No scripts changed, checked %u in %.2f ms", unchangedCount, timer.GetLifeTime() * 1000);
+		return;
+	}
+
+	// Hooks of every module that isn't touched stay as they are, the new set is only published once everything is loaded
+	PacketHooks::BeginUpdate();
+
+	asIScriptEngine* engine = ScriptEngine::GetScriptEngine()->asEngine();
+	for (std::string const& path : removedScripts)
+	{
+		std::string const& moduleName = _scripts[path].moduleName;
+		PacketHooks::RemoveModuleHooks(moduleName);
+		engine->DiscardModule(moduleName.c_str());
+		_scripts.erase(path);
+	}
+
+	size_t reloadedCount = 0;
+	for (ScriptLoadTask& task : tasks)
 	{
-		LoadScriptDirectory(_path);
+		PacketHooks::RemoveModuleHooks(task.moduleName);
+		if (LoadScript(task))
+		{
+			RecordScript(task);
+			reloadedCount++;
+		}
+		else
+		{
+			// Whatever the broken version managed to register is dropped in favour of the hooks it had before
+			PacketHooks::RestoreModuleHooks(task.moduleName);
+			NC_LOG_WARNING("[Script]: %s failed to reload, keeping its previous hooks", task.moduleName.c_str());
+		}
 	}
+
+	PacketHooks::CommitUpdate();
+
+	NC_LOG_SUCCESS("Reloaded %u of %u changed scripts, removed %u and kept %u unchanged in %.2f ms", reloadedCount, tasks.size(), removedScripts.size(), unchangedCount, timer.GetLifeTime() * 1000);
 }
 
 void MessageCallback(const asSMessageInfo *msg, void *param)
@@ -63,55 +162,242 @@ void ScriptHandler::LoadScriptDirectory(std::string& path)
 	fs::path absolutePath = fs::absolute(path);
 
 	Timer timer;
-	size_t count = 0;
+	std::vector<ScriptLoadTask> tasks;
 	for (auto& p : fs::recursive_directory_iterator(absolutePath))
 	{
 		if (p.is_directory())
 			continue;
 
-		if (LoadScript(p.path()))
+		ScriptLoadTask& task = tasks.emplace_back();
+		task.path = p.path();
+		task.moduleName = p.path().filename().string();
+	}
+
+	Timer prepareTimer;
+	size_t workerCount = PrepareScripts(tasks);
+	f32 msPrepareTime = prepareTimer.GetLifeTime() * 1000;
+
+	size_t count = 0;
+	size_t cachedCount = 0;
+	PacketHooks::BeginUpdate();
+	for (ScriptLoadTask& task : tasks)
+	{
+		if (LoadScript(task))
 		{
+			RecordScript(task);
+
 			count++;
+			if (task.loadedFromCache)
+				cachedCount++;
 		}
 	}
+	PacketHooks::CommitUpdate();
 	f32 msTimeTaken = timer.GetLifeTime()*1000;
-	NC_LOG_SUCCESS("Loaded %u scripts in %.2f ms", count, msTimeTaken);
+	NC_LOG_SUCCESS("Loaded %u scripts (%u from cache) in %.2f ms, %.2f ms reading on %u threads", count, cachedCount, msTimeTaken, msPrepareTime, workerCount);
+
+	// Only the slowest few are worth showing when a large scenario pack is loaded
+	std::sort(tasks.begin(), tasks.end(), [](ScriptLoadTask const& a, ScriptLoadTask const& b) { return a.prepareTime + a.loadTime > b.prepareTime + b.loadTime; });
+	for (size_t i = 0; i < tasks.size() && i < SLOWEST_SCRIPT_COUNT; i++)
+	{
+		ScriptLoadTask const& task = tasks[i];
+		NC_LOG_MESSAGE("[Script]: %s %s in %.2f ms (%.2f ms reading)", task.moduleName.c_str(), task.loadedFromCache ? "loaded" : "built", task.prepareTime + task.loadTime, task.prepareTime);
+	}
+
+	if (!_loadTimesPath.empty())
+		WriteLoadTimes(tasks);
 }
 
-bool ScriptHandler::LoadScript(fs::path path)
+void ScriptHandler::WriteLoadTimes(std::vector<ScriptLoadTask> const& tasks)
 {
-	AngelBinder::Engine* engine = ScriptEngine::GetScriptEngine();
+	std::ofstream file(_loadTimesPath, std::ios::trunc);
+	if (!file)
+	{
+		NC_LOG_WARNING("Could not write script load times to %s", _loadTimesPath.c_str());
+		return;
+	}
+
+	file << "script\tsource\ttotal ms\treading ms\tpath\n";
+	for (ScriptLoadTask const& task : tasks)
+	{
+		file << task.moduleName << '\t' << (task.loadedFromCache ? "cache" : "built") << '\t' << task.prepareTime + task.loadTime << '\t' << task.prepareTime << '\t' << task.path.string() << '\n';
+	}
 
-	std::string moduleName = path.filename().string();
+	NC_LOG_MESSAGE("[Script]: Wrote load times of %u scripts to %s", static_cast<u32>(tasks.size()), _loadTimesPath.c_str());
+}
 
-	CScriptBuilder builder;
-	int r = builder.StartNewModule(engine->asEngine(), moduleName.c_str());
-	if (r < 0)
+size_t ScriptHandler::PrepareScripts(std::vector<ScriptLoadTask>& tasks)
+{
+	// Reading, hashing and validating cache entries never touches the engine so it's spread over worker threads,
+	// building and registering modules with the engine stays on this thread
+	ScriptHash const& fingerprint = ScriptCache::GetFingerprint(ScriptEngine::GetScriptEngine()->asEngine());
+
+	std::atomic<size_t> nextTask(0);
+	auto prepareTasks = [&tasks, &nextTask, &fingerprint]()
 	{
-		// If the code fails here it is usually because there
-		// is no more memory to allocate the module
-		NC_LOG_ERROR("[Script]: Unrecoverable error while starting a new module.");
-		return false;
+		for (size_t i = nextTask++; i < tasks.size(); i = nextTask++)
+		{
+			PrepareScript(tasks[i], fingerprint);
+		}
+	};
+
+	size_t workerCount = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), tasks.size());
+	std::vector<std::thread> workers;
+	for (size_t i = 1; i < workerCount; i++)
+	{
+		workers.emplace_back(prepareTasks);
 	}
-	r = builder.AddSectionFromFile(path.string().c_str());
-	if (r < 0)
+	prepareTasks();
+
+	for (std::thread& worker : workers)
 	{
-		// The builder wasn't able to load the file. Maybe the file
-		// has been removed, or the wrong name was given, or some
-		// preprocessing commands are incorrectly written.
-		NC_LOG_ERROR("[Script]: Please correct the errors in the script and try again.\n");
-		return false;
+		worker.join();
 	}
-	r = builder.BuildModule();
-	if (r < 0)
+
+	return workerCount;
+}
+
+void ScriptHandler::RecordScript(ScriptLoadTask const& task)
+{
+	LoadedScript& script = _scripts[NormalizePath(task.path)];
+	script.moduleName = task.moduleName;
+	script.seen = true;
+	script.sections.clear();
+
+	for (ScriptSection const& section : task.sections)
 	{
-		// An error occurred. Instruct the script writer to fix the 
-		// compilation errors that were listed in the output stream.
-		NC_LOG_ERROR("[Script]: Please correct the errors in the script and try again.\n");
+		std::error_code error;
+		script.sections.push_back({ section.name, section.hash, fs::last_write_time(section.name, error) });
+	}
+}
+
+bool ScriptHandler::IsModified(LoadedScript const& script)
+{
+	for (LoadedSection const& section : script.sections)
+	{
+		std::error_code error;
+		if (fs::last_write_time(section.name, error) != section.writeTime || error)
+			return true;
+	}
+
+	return false;
+}
+
+bool ScriptHandler::HasSameSections(LoadedScript const& script, std::vector<ScriptSection> const& sections)
+{
+	if (script.sections.size() != sections.size())
 		return false;
+
+	for (ScriptSection const& section : sections)
+	{
+		auto isSameSection = [&section](LoadedSection const& loadedSection) { return loadedSection.name == section.name && loadedSection.hash == section.hash; };
+		if (std::find_if(script.sections.begin(), script.sections.end(), isSameSection) == script.sections.end())
+			return false;
+	}
+
+	return true;
+}
+
+std::string ScriptHandler::NormalizePath(fs::path const& path)
+{
+	// Matches the names the script builder gives sections so includes resolve to the same section either way
+	return fs::absolute(path).lexically_normal().generic_string();
+}
+
+bool ScriptHandler::ReadSection(std::string const& name, std::vector<ScriptSection>& sections)
+{
+	std::ifstream file(name, std::ios::binary);
+	if (!file)
+		return false;
+
+	ScriptSection& section = sections.emplace_back();
+	section.name = name;
+	section.source.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	ScriptCache::HashSource(section.source, section.hash);
+	return true;
+}
+
+void ScriptHandler::PrepareScript(ScriptLoadTask& task, ScriptHash const& fingerprint)
+{
+	Timer timer;
+
+	task.hasCacheEntry = ScriptCache::ReadEntry(task.path, fingerprint, task.cacheEntry, task.byteCodeOffset, task.sections);
+	if (!task.hasCacheEntry)
+		ReadSections(task);
+
+	task.prepareTime = timer.GetLifeTime() * 1000;
+}
+
+void ScriptHandler::ReadSections(ScriptLoadTask& task)
+{
+	task.sections.clear();
+	if (!ReadSection(NormalizePath(task.path), task.sections))
+		return;
+
+	// Includes are read up front as well, the builder is handed them from memory once it gets to them.
+	// This only looks for plain #include lines, anything it misses is still loaded from disk by the builder
+	for (size_t i = 0; i < task.sections.size(); i++)
+	{
+		fs::path directory = fs::path(task.sections[i].name).parent_path();
+		std::istringstream source(task.sections[i].source);
+
+		std::string line;
+		while (std::getline(source, line))
+		{
+			size_t start = line.find_first_not_of(" \t");
+			if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
+				continue;
+
+			size_t nameStart = line.find('"', start + 8);
+			size_t nameEnd = nameStart == std::string::npos ? nameStart : line.find('"', nameStart + 1);
+			if (nameEnd == std::string::npos)
+				continue;
+
+			std::string includeName = NormalizePath(directory / line.substr(nameStart + 1, nameEnd - nameStart - 1));
+			auto isIncluded = [&includeName](ScriptSection const& section) { return section.name == includeName; };
+			if (std::find_if(task.sections.begin(), task.sections.end(), isIncluded) == task.sections.end())
+			{
+				ReadSection(includeName, task.sections);
+			}
+		}
+	}
+}
+
+int ScriptHandler::IncludeCallback(const char* include, const char* from, CScriptBuilder* builder, void* userParam)
+{
+	ScriptLoadTask* task = static_cast<ScriptLoadTask*>(userParam);
+
+	fs::path includePath(include);
+	if (includePath.is_relative())
+		includePath = fs::path(from).parent_path() / includePath;
+
+	std::string includeName = NormalizePath(includePath);
+	for (ScriptSection const& section : task->sections)
+	{
+		if (section.name == includeName)
+			return builder->AddSectionFromMemory(section.name.c_str(), section.source.c_str(), static_cast<unsigned int>(section.source.size()));
+	}
+
+	return builder->AddSectionFromFile(includeName.c_str());
+}
+
+bool ScriptHandler::LoadScript(ScriptLoadTask& task)
+{
+	AngelBinder::Engine* engine = ScriptEngine::GetScriptEngine();
+
+	Timer timer;
+	task.loadedFromCache = task.hasCacheEntry && ScriptCache::LoadEntry(engine->asEngine(), task.moduleName, task.cacheEntry, task.byteCodeOffset);
+	if (!task.loadedFromCache)
+	{
+		// The entry looked valid but its bytecode wasn't, the sources were never read in that case
+		if (task.hasCacheEntry)
+			ReadSections(task);
+
+		if (!BuildScript(engine, task))
+			return false;
 	}
+	task.loadTime = timer.GetLifeTime() * 1000;
 
-	asIScriptModule *mod = engine->asEngine()->GetModule(moduleName.c_str());
+	asIScriptModule *mod = engine->asEngine()->GetModule(task.moduleName.c_str());
 	asIScriptFunction *func = mod->GetFunctionByDecl("void main()");
 	if (func == 0)
 	{
@@ -124,7 +410,11 @@ bool ScriptHandler::LoadScript(fs::path path)
 	// Create our context, prepare it, and then execute
 	asIScriptContext *ctx = engine->asEngine()->CreateContext();
 	ctx->Prepare(func);
-	r = ctx->Execute();
+	int r;
+	{
+		ScriptProfiler::Scope scope(ctx, "Main");
+		r = ctx->Execute();
+	}
 	if (r != asEXECUTION_FINISHED)
 	{
 		// The execution didn't complete as expected. Determine what happened.
@@ -141,6 +431,59 @@ bool ScriptHandler::LoadScript(fs::path path)
 	return true;
 }
 
+bool ScriptHandler::BuildScript(AngelBinder::Engine* engine, ScriptLoadTask& task)
+{
+	if (task.sections.empty())
+	{
+		NC_LOG_ERROR("[Script]: Failed to read script file '%s'", task.path.string().c_str());
+		return false;
+	}
+
+	CScriptBuilder builder;
+	int r = builder.StartNewModule(engine->asEngine(), task.moduleName.c_str());
+	if (r < 0)
+	{
+		// If the code fails here it is usually because there
+		// is no more memory to allocate the module
+		NC_LOG_ERROR("[Script]: Unrecoverable error while starting a new module.");
+		return false;
+	}
+
+	ScriptSection const& script = task.sections.front();
+	builder.SetIncludeCallback(&ScriptHandler::IncludeCallback, &task);
+	r = builder.AddSectionFromMemory(script.name.c_str(), script.source.c_str(), static_cast<unsigned int>(script.source.size()));
+	if (r < 0)
+	{
+		// The builder wasn't able to load the file. Maybe the file
+		// has been removed, or the wrong name was given, or some
+		// preprocessing commands are incorrectly written.
+		NC_LOG_ERROR("[Script]: Please correct the errors in the script and try again.\n");
+		return false;
+	}
+	r = builder.BuildModule();
+	if (r < 0)
+	{
+		// An error occurred. Instruct the script writer to fix the 
+		// compilation errors that were listed in the output stream.
+		NC_LOG_ERROR("[Script]: Please correct the errors in the script and try again.\n");
+		return false;
+	}
+
+	// Keep track of includes the scan missed so reloads notice when they change
+	for (u32 i = 0; i < builder.GetSectionCount(); i++)
+	{
+		std::string sectionName = builder.GetSectionName(i);
+		auto isSection = [&sectionName](ScriptSection const& section) { return section.name == sectionName; };
+		if (std::find_if(task.sections.begin(), task.sections.end(), isSection) == task.sections.end())
+		{
+			ReadSection(sectionName, task.sections);
+		}
+	}
+
+	ScriptCache::Save(engine->asEngine()->GetModule(task.moduleName.c_str()), builder, task.path, task.sections);
+	return true;
+}
+
 void ScriptHandler::RegisterFunctions(AngelBinder::Engine* engine)
 {
 	// Defaults
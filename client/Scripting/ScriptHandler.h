@@ -1,25 +1,81 @@
 #pragma once
 #include <string>
 #include <filesystem>
+#include <vector>
 #include <asio.hpp>
+#include <robin_hood.h>
+#include "ScriptCache.h"
 
 namespace AngelBinder
 {
 	class Engine;
 }
 
+// Everything gathered about a script on the worker threads before it is loaded into the engine
+struct ScriptLoadTask
+{
+	std::filesystem::path path;
+	std::string moduleName;
+
+	bool hasCacheEntry = false;
+	std::vector<u8> cacheEntry;
+	size_t byteCodeOffset = 0;
+
+	// The script itself first, followed by the includes that were found. Sections taken from a cache entry have no source
+	std::vector<ScriptSection> sections;
+
+	bool loadedFromCache = false;
+	f32 prepareTime = 0;
+	f32 loadTime = 0;
+};
+
 class ScriptHandler
 {
 public:
 	static void SetIOService(asio::io_service* service) { _ioService = service; }
+	// Every script's load time is written here when set, the log only shows the slowest few
+	static void SetLoadTimesPath(std::string const& path) { _loadTimesPath = path; }
 	static void LoadScriptDirectory(std::string& path);
+	// Only rebuilds scripts that changed since they were loaded and swaps in their hooks in one go
 	static void ReloadScripts();
 private:
-	static bool LoadScript(std::filesystem::path path);
+	struct LoadedSection
+	{
+		std::string name;
+		ScriptHash hash;
+		std::filesystem::file_time_type writeTime;
+	};
+
+	struct LoadedScript
+	{
+		std::string moduleName;
+		std::vector<LoadedSection> sections;
+		bool seen;
+	};
+
+	static constexpr size_t SLOWEST_SCRIPT_COUNT = 5;
+
+	static size_t PrepareScripts(std::vector<ScriptLoadTask>& tasks);
+	static void RecordScript(ScriptLoadTask const& task);
+	static void WriteLoadTimes(std::vector<ScriptLoadTask> const& tasks);
+	static bool IsModified(LoadedScript const& script);
+	static bool HasSameSections(LoadedScript const& script, std::vector<ScriptSection> const& sections);
+
+	static std::string NormalizePath(std::filesystem::path const& path);
+	static bool ReadSection(std::string const& name, std::vector<ScriptSection>& sections);
+	static void ReadSections(ScriptLoadTask& task);
+	static void PrepareScript(ScriptLoadTask& task, ScriptHash const& fingerprint);
+	static int IncludeCallback(const char* include, const char* from, CScriptBuilder* builder, void* userParam);
+
+	static bool LoadScript(ScriptLoadTask& task);
+	static bool BuildScript(AngelBinder::Engine* engine, ScriptLoadTask& task);
 	static void RegisterFunctions(AngelBinder::Engine* engine);
 
 	ScriptHandler();
 private:
 	static std::string _path;
+	static std::string _loadTimesPath;
 	static asio::io_service* _ioService;
+	// Every loaded script by its normalized path
+	static robin_hood::unordered_node_map<std::string, LoadedScript> _scripts;
 };
\ No newline at end of file
@@ -0,0 +1,275 @@
+#include "ScriptProfiler.h"
+#include "../Utils/DebugHandler.h"
+#include "AngelBinder.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+constexpr size_t PROFILE_TOP_COUNT = 5;
+
+std::atomic<bool> ScriptProfiler::_running(false);
+u32 ScriptProfiler::_sampleInterval = 100;
+
+std::mutex ScriptProfiler::_threadsMutex;
+std::vector<std::shared_ptr<ScriptProfiler::ThreadProfile>> ScriptProfiler::_threads;
+
+thread_local ScriptProfiler::Scope* ScriptProfiler::_currentScope = nullptr;
+
+ScriptProfiler::Scope::Scope(asIScriptContext* context, char const* label, u32 labelId) : _context(nullptr), _label(label), _labelId(labelId), _lines(0), _parent(nullptr), _lastCpuTime(0)
+{
+	// Not profiling costs a single load per execution
+	if (!IsRunning())
+		return;
+
+	_context = context;
+	_parent = _currentScope;
+	_currentScope = this;
+
+	// Time spent before the first sample is charged to where the execution started, or resumed for coroutines
+	BuildStack(*this, _lastStack);
+	_lastWallTime = std::chrono::steady_clock::now();
+	_lastCpuTime = GetThreadCpuTime();
+
+	context->SetLineCallback(asFUNCTION(ScriptProfiler::LineCallback), nullptr, asCALL_CDECL);
+}
+
+ScriptProfiler::Scope::~Scope()
+{
+	if (!_context)
+		return;
+
+	_context->ClearLineCallback();
+
+	std::chrono::steady_clock::time_point wallTime = std::chrono::steady_clock::now();
+	u64 cpuTime = GetThreadCpuTime();
+	Record(_lastStack, std::chrono::duration_cast<std::chrono::nanoseconds>(wallTime - _lastWallTime).count(), cpuTime - _lastCpuTime);
+
+	// A nested execution is charged to its own scope, not to the one that triggered it
+	_currentScope = _parent;
+	if (_parent)
+	{
+		_parent->_lastWallTime = wallTime;
+		_parent->_lastCpuTime = cpuTime;
+	}
+}
+
+void ScriptProfiler::Start()
+{
+	_running = true;
+	NC_LOG_MESSAGE("[Profile]: Sampling script stacks every %u lines", _sampleInterval);
+}
+
+void ScriptProfiler::Stop()
+{
+	_running = false;
+}
+
+void ScriptProfiler::Reset()
+{
+	std::lock_guard<std::mutex> threadsLock(_threadsMutex);
+	for (std::shared_ptr<ThreadProfile> const& thread : _threads)
+	{
+		std::lock_guard<std::mutex> lock(thread->mutex);
+		thread->stacks.clear();
+	}
+}
+
+void ScriptProfiler::LineCallback(asIScriptContext* context, void* /*param*/)
+{
+	Scope* scope = _currentScope;
+	if (!scope || scope->_context != context)
+		return;
+
+	if (++scope->_lines < _sampleInterval)
+		return;
+
+	scope->_lines = 0;
+	Sample(*scope);
+}
+
+void ScriptProfiler::Sample(Scope& scope)
+{
+	thread_local std::string stack;
+	BuildStack(scope, stack);
+
+	std::chrono::steady_clock::time_point wallTime = std::chrono::steady_clock::now();
+	u64 cpuTime = GetThreadCpuTime();
+	Record(stack, std::chrono::duration_cast<std::chrono::nanoseconds>(wallTime - scope._lastWallTime).count(), cpuTime - scope._lastCpuTime);
+
+	scope._lastWallTime = wallTime;
+	scope._lastCpuTime = cpuTime;
+	scope._lastStack = stack;
+}
+
+void ScriptProfiler::BuildStack(Scope const& scope, std::string& stack)
+{
+	char frame[32];
+
+	stack = scope._label;
+	if (scope._labelId)
+	{
+		std::snprintf(frame, sizeof(frame), " 0x%X", scope._labelId);
+		stack += frame;
+	}
+
+	// Outermost frame first, the innermost frame ends up as the leaf with the line currently executing
+	for (asUINT level = scope._context->GetCallstackSize(); level-- > 0;)
+	{
+		asIScriptFunction* function = scope._context->GetFunction(level);
+		if (!function)
+			continue;
+
+		char const* section = nullptr;
+		int line = scope._context->GetLineNumber(level, nullptr, &section);
+
+		// Sections are named by their full path, the file name is enough to tell frames apart
+		char const* fileName = section ? section : "unknown";
+		for (char const* c = fileName; *c; c++)
+		{
+			if (*c == '/' || *c == '\\')
+				fileName = c + 1;
+		}
+
+		stack += ';';
+		if (function->GetNamespace() && function->GetNamespace()[0])
+		{
+			stack += function->GetNamespace();
+			stack += "::";
+		}
+		stack += function->GetName();
+		stack += " (";
+		stack += fileName;
+		std::snprintf(frame, sizeof(frame), ":%d)", line);
+		stack += frame;
+	}
+}
+
+void ScriptProfiler::Record(std::string const& stack, u64 wallTime, u64 cpuTime)
+{
+	ThreadProfile& profile = GetThreadProfile();
+	std::lock_guard<std::mutex> lock(profile.mutex);
+
+	auto itr = profile.stacks.find(stack);
+	if (itr == profile.stacks.end())
+		itr = profile.stacks.emplace(stack, ScriptCost()).first;
+
+	itr->second.wallTime += wallTime;
+	itr->second.cpuTime += cpuTime;
+	itr->second.samples++;
+}
+
+u64 ScriptProfiler::GetThreadCpuTime()
+{
+#if defined(_WIN32)
+	// Only updated once per scheduler quantum, individual deltas are coarse but their sum over many samples is not
+	FILETIME creationTime, exitTime, kernelTime, userTime;
+	if (!GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime))
+		return 0;
+
+	u64 kernel = (static_cast<u64>(kernelTime.dwHighDateTime) << 32) | kernelTime.dwLowDateTime;
+	u64 user = (static_cast<u64>(userTime.dwHighDateTime) << 32) | userTime.dwLowDateTime;
+	return (kernel + user) * 100;
+#else
+	timespec time;
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0)
+		return 0;
+
+	return static_cast<u64>(time.tv_sec) * 1000000000 + time.tv_nsec;
+#endif
+}
+
+ScriptProfiler::ThreadProfile& ScriptProfiler::GetThreadProfile()
+{
+	// Threads only ever lock their own profile while recording, the shared list keeps it around after the thread exits
+	thread_local std::shared_ptr<ThreadProfile> profile;
+	if (!profile)
+	{
+		profile = std::make_shared<ThreadProfile>();
+
+		std::lock_guard<std::mutex> lock(_threadsMutex);
+		_threads.push_back(profile);
+	}
+
+	return *profile;
+}
+
+static void PrintTopCosts(char const* kind, std::map<std::string, ScriptCost> const& costs, u64 totalWallTime)
+{
+	std::vector<std::pair<std::string, ScriptCost>> sorted(costs.begin(), costs.end());
+	std::sort(sorted.begin(), sorted.end(), [](auto const& a, auto const& b) { return a.second.wallTime > b.second.wallTime; });
+
+	for (size_t i = 0; i < sorted.size() && i < PROFILE_TOP_COUNT; i++)
+	{
+		ScriptCost const& cost = sorted[i].second;
+		NC_LOG_MESSAGE("[Profile]: %s %s %.2f ms wall (%.1f%%), %.2f ms cpu, %llu samples", kind, sorted[i].first.c_str(), cost.wallTime / 1000000.0, totalWallTime ? cost.wallTime * 100.0 / totalWallTime : 0.0, cost.cpuTime / 1000000.0, cost.samples);
+	}
+}
+
+bool ScriptProfiler::Dump(std::string const& path)
+{
+	std::map<std::string, ScriptCost> stacks;
+	{
+		std::lock_guard<std::mutex> threadsLock(_threadsMutex);
+		for (std::shared_ptr<ThreadProfile> const& thread : _threads)
+		{
+			std::lock_guard<std::mutex> lock(thread->mutex);
+			for (auto const& entry : thread->stacks)
+			{
+				ScriptCost& cost = stacks[entry.first];
+				cost.wallTime += entry.second.wallTime;
+				cost.cpuTime += entry.second.cpuTime;
+				cost.samples += entry.second.samples;
+			}
+		}
+	}
+
+	std::ofstream wallFile(path + ".wall.folded", std::ios::trunc);
+	std::ofstream cpuFile(path + ".cpu.folded", std::ios::trunc);
+	if (!wallFile || !cpuFile)
+	{
+		NC_LOG_ERROR("[Profile]: Could not open '%s' for writing", path.c_str());
+		return false;
+	}
+
+	// The leaf frame is the line a sample was taken on, self time per function and per line falls out of it directly
+	std::map<std::string, ScriptCost> functions;
+	std::map<std::string, ScriptCost> lines;
+	ScriptCost total;
+
+	for (auto const& entry : stacks)
+	{
+		ScriptCost const& cost = entry.second;
+
+		// Folded stacks only take whole numbers, microseconds keep short hooks visible
+		if (cost.wallTime >= 1000)
+			wallFile << entry.first << ' ' << cost.wallTime / 1000 << '\n';
+		if (cost.cpuTime >= 1000)
+			cpuFile << entry.first << ' ' << cost.cpuTime / 1000 << '\n';
+
+		size_t leafStart = entry.first.rfind(';');
+		if (leafStart == std::string::npos)
+			continue;
+
+		std::string leaf = entry.first.substr(leafStart + 1);
+		std::string function = leaf.substr(0, leaf.rfind(':')) + ")";
+
+		for (ScriptCost* sum : { &lines[leaf], &functions[function], &total })
+		{
+			sum->wallTime += cost.wallTime;
+			sum->cpuTime += cost.cpuTime;
+			sum->samples += cost.samples;
+		}
+	}
+
+	NC_LOG_MESSAGE("[Profile]: Wrote %u stacks to %s.wall.folded and %s.cpu.folded, %.2f ms wall and %.2f ms cpu in scripts", static_cast<u32>(stacks.size()), path.c_str(), path.c_str(), total.wallTime / 1000000.0, total.cpuTime / 1000000.0);
+	PrintTopCosts("Function", functions, total.wallTime);
+	PrintTopCosts("Line", lines, total.wallTime);
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+#include "../NovusTypes.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <robin_hood.h>
+
+class asIScriptContext;
+
+struct ScriptCost
+{
+	u64 wallTime = 0;
+	u64 cpuTime = 0;
+	u64 samples = 0;
+};
+
+// Attributes script execution time to the hook that started it and the script call stack it was spent in. Every execution
+// is wrapped in a Scope, while the profiler runs the scope installs a line callback that only walks the call stack every
+// few lines, so the overhead stays small enough to leave the profiler running during a load test. The time between two
+// samples is charged to the stack seen at the later one, the tail after the last sample goes to the stack that sample
+// saw, or to the root frame when none was taken. Everything is collected per thread, dumping merges the threads into
+// folded stack files that flamegraph.pl and speedscope read directly.
+class ScriptProfiler
+{
+public:
+	class Scope
+	{
+	public:
+		// The label names the root frame, opcode hooks pass the opcode they were called for
+		Scope(asIScriptContext* context, char const* label, u32 labelId = 0);
+		~Scope();
+
+		Scope(Scope const&) = delete;
+		Scope& operator=(Scope const&) = delete;
+
+	private:
+		friend class ScriptProfiler;
+
+		asIScriptContext* _context;
+		char const* _label;
+		u32 _labelId;
+		u32 _lines;
+		Scope* _parent;
+		std::chrono::steady_clock::time_point _lastWallTime;
+		u64 _lastCpuTime;
+		std::string _lastStack;
+	};
+
+	static void SetSampleInterval(u32 lines) { _sampleInterval = lines > 0 ? lines : 1; }
+	static void Start();
+	static void Stop();
+	static void Reset();
+	inline static bool IsRunning() { return _running.load(std::memory_order_relaxed); }
+
+	// Writes <path>.wall.folded and <path>.cpu.folded with microseconds per stack and logs the costliest functions and lines
+	static bool Dump(std::string const& path);
+
+private:
+	struct ThreadProfile
+	{
+		std::mutex mutex;
+		robin_hood::unordered_node_map<std::string, ScriptCost> stacks;
+	};
+
+	static void LineCallback(asIScriptContext* context, void* param);
+	static void Sample(Scope& scope);
+	static void BuildStack(Scope const& scope, std::string& stack);
+	static void Record(std::string const& stack, u64 wallTime, u64 cpuTime);
+	static u64 GetThreadCpuTime();
+	static ThreadProfile& GetThreadProfile();
+
+	static std::atomic<bool> _running;
+	static u32 _sampleInterval;
+
+	static std::mutex _threadsMutex;
+	static std::vector<std::shared_ptr<ThreadProfile>> _threads;
+
+	static thread_local Scope* _currentScope;
+};
\ No newline at end of file
@@ -0,0 +1,127 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#include "ArrivalScheduler.h"
+#include <cmath>
+
+// 1 ms slots, 256 of them cover more than the refill horizon
+constexpr u64 WHEEL_RESOLUTION = 1000;
+constexpr size_t WHEEL_SLOTS = 256;
+constexpr u64 REFILL_HORIZON = 100000;
+
+ArrivalScheduler::ArrivalScheduler() : _schedule(), _isRunning(false), _startTime(), _maxArrivals(0), _scheduled(0), _started(0), _nextArrival(0.0),
+    _wheel(WHEEL_RESOLUTION, WHEEL_SLOTS), _random(std::random_device()()), _startLag() { }
+
+bool ArrivalScheduler::ParseMode(std::string const& name, ArrivalMode& mode)
+{
+    for (u32 i = 0; i < ARRIVAL_COUNT; i++)
+    {
+        if (name == GetModeName(static_cast<ArrivalMode>(i)))
+        {
+            mode = static_cast<ArrivalMode>(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+char const* ArrivalScheduler::GetModeName(ArrivalMode mode)
+{
+    switch (mode)
+    {
+        case ARRIVAL_CONSTANT: return "constant";
+        case ARRIVAL_LINEAR: return "linear";
+        case ARRIVAL_STEP: return "step";
+        case ARRIVAL_POISSON: return "poisson";
+        default: return "unknown";
+    }
+}
+
+void ArrivalScheduler::Start(ArrivalSchedule const& schedule, u64 maxArrivals)
+{
+    _schedule = schedule;
+    _maxArrivals = maxArrivals;
+    _scheduled = 0;
+    _started = 0;
+    _nextArrival = 0.0;
+    _startTime = Clock::now();
+    _isRunning = true;
+}
+
+f64 ArrivalScheduler::GetRate(f64 seconds) const
+{
+    switch (_schedule.mode)
+    {
+        case ARRIVAL_LINEAR:
+        {
+            if (_schedule.rampDuration <= 0.0 || seconds >= _schedule.rampDuration)
+                return _schedule.rateEnd;
+
+            return _schedule.rate + (_schedule.rateEnd - _schedule.rate) * (seconds / _schedule.rampDuration);
+        }
+        case ARRIVAL_STEP:
+        {
+            if (_schedule.stepInterval <= 0.0)
+                return _schedule.rate;
+
+            return _schedule.rate + std::floor(seconds / _schedule.stepInterval) * _schedule.stepRate;
+        }
+        default:
+            return _schedule.rate;
+    }
+}
+
+u64 ArrivalScheduler::GetElapsed() const
+{
+    return static_cast<u64>(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - _startTime).count());
+}
+
+void ArrivalScheduler::Refill(u64 now)
+{
+    std::uniform_real_distribution<f64> uniform(0.0, 1.0);
+
+    while (_scheduled < _maxArrivals && _nextArrival <= static_cast<f64>(now + REFILL_HORIZON))
+    {
+        f64 rate = GetRate(_nextArrival / 1000000.0);
+        if (rate <= 0.0)
+        {
+            // Nothing arrives while the rate is zero, look again a millisecond later
+            _nextArrival += static_cast<f64>(WHEEL_RESOLUTION);
+            continue;
+        }
+
+        _wheel.Schedule(static_cast<u64>(_nextArrival), static_cast<u64>(_nextArrival));
+        _scheduled++;
+
+        // The gap uses the rate at the previous arrival, close enough at the rates a ramp changes over
+        f64 gap = 1000000.0 / rate;
+        if (_schedule.mode == ARRIVAL_POISSON)
+            gap *= -std::log(1.0 - uniform(_random));
+
+        _nextArrival += gap;
+    }
+
+    if (_scheduled == _maxArrivals && _wheel.Empty())
+        _isRunning = false;
+}
\ No newline at end of file
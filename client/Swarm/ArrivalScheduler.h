@@ -0,0 +1,119 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include <chrono>
+#include <random>
+#include <string>
+#include "../NovusTypes.h"
+#include "../Utils/TimerWheel.h"
+#include "../Utils/LatencyHistogram.h"
+
+enum ArrivalMode
+{
+    ARRIVAL_CONSTANT,
+    ARRIVAL_LINEAR,
+    ARRIVAL_STEP,
+    ARRIVAL_POISSON,
+    ARRIVAL_COUNT
+};
+
+// Rates are in sessions per second, durations in seconds
+struct ArrivalSchedule
+{
+    ArrivalMode mode = ARRIVAL_CONSTANT;
+    f64 rate = 100.0;
+    // Linear ramps from rate to rateEnd over rampDuration and holds rateEnd afterwards
+    f64 rateEnd = 1000.0;
+    f64 rampDuration = 60.0;
+    // Step adds stepRate every stepInterval
+    f64 stepRate = 50.0;
+    f64 stepInterval = 10.0;
+};
+
+// Open loop session starts, arrivals follow the target rate no matter how quickly earlier logins complete so a server
+// that falls behind shows up as a growing number of logins in flight instead of a silently lower offered load.
+// Arrival times are generated a short horizon ahead into a timer wheel which the owner advances from its own thread.
+class ArrivalScheduler
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    ArrivalScheduler();
+
+    static bool ParseMode(std::string const& name, ArrivalMode& mode);
+    static char const* GetModeName(ArrivalMode mode);
+
+    void Start(ArrivalSchedule const& schedule, u64 maxArrivals);
+
+    // Calls spawner once for every arrival that came due, stops early if the spawner returns false
+    template <typename Spawner>
+    void Update(Spawner spawner)
+    {
+        if (!_isRunning)
+            return;
+
+        u64 now = GetElapsed();
+        Refill(now);
+
+        _wheel.Advance(now, [&](u64 deadline)
+        {
+            if (!_isRunning)
+                return;
+
+            // How late a session started compared to its scheduled arrival, mostly our own tick and spawn overhead
+            _startLag.Record(now - std::min(now, deadline));
+            _started++;
+
+            if (!spawner())
+                _isRunning = false;
+        });
+    }
+
+    ArrivalSchedule const& GetSchedule() const { return _schedule; }
+    f64 GetCurrentRate() const { return GetRate(GetElapsed() / 1000000.0); }
+    u64 GetStarted() const { return _started; }
+    void GetStartLag(LatencySummary& summary) const { _startLag.GetSummary(summary); }
+
+private:
+    f64 GetRate(f64 seconds) const;
+    u64 GetElapsed() const;
+    // Generates arrivals into the wheel until the horizon is covered
+    void Refill(u64 now);
+
+private:
+    ArrivalSchedule _schedule;
+    bool _isRunning;
+    Clock::time_point _startTime;
+
+    u64 _maxArrivals;
+    u64 _scheduled;
+    u64 _started;
+    // Time of the next arrival to generate in microseconds since Start, kept fractional so high rates don't drift
+    f64 _nextArrival;
+
+    TimerWheel<u64> _wheel;
+    std::mt19937_64 _random;
+    LatencyHistogram _startLag;
+};
\ No newline at end of file
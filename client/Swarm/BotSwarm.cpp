@@ -0,0 +1,210 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+
+#include "BotSwarm.h"
+#include "../Connection/NovusConnection.h"
+#include "../Config/ConfigHandler.h"
+#include "../Utils/DebugHandler.h"
+
+BotSwarm::BotSwarm() : _isEnabled(false), _botCount(0), _spawnPerTick(0), _port(0), _ioService(nullptr), _useArrivals(false), _arrivals(), _replay(), _replayStart() { }
+
+BotSwarm::~BotSwarm()
+{
+}
+
+void BotSwarm::Start(asio::io_service* ioService)
+{
+    _isEnabled = ConfigHandler::GetOption<bool>("swarmEnabled", false);
+    if (!_isEnabled)
+        return;
+
+    _ioService = ioService;
+    _botCount = ConfigHandler::GetOption<u32>("botCount", 100);
+    _spawnPerTick = ConfigHandler::GetOption<u32>("botSpawnPerTick", 50);
+    _usernamePrefix = ConfigHandler::GetOption<std::string>("botUsernamePrefix", "bot");
+    _password = ConfigHandler::GetOption<std::string>("botPassword", "password");
+    _address = ConfigHandler::GetOption<std::string>("address", "127.0.0.1");
+    _port = ConfigHandler::GetOption<u16>("port", 3724);
+
+    std::string replayFile = ConfigHandler::GetOption<std::string>("replayFile", "");
+    if (!replayFile.empty())
+    {
+        _replay = std::make_unique<ReplayCapture>();
+        if (!_replay->Load(replayFile))
+        {
+            _replay.reset();
+            _isEnabled = false;
+            return;
+        }
+
+        _replay->SetTimeScale(ConfigHandler::GetOption<f64>("replayTimeScale", 1.0));
+        _botCount = static_cast<u32>(_replay->GetStreams().size());
+        _replayStart = std::chrono::steady_clock::now();
+    }
+
+    // Reserve up front so the bot table never reallocates while bots are being spawned
+    _bots.reserve(_botCount);
+
+    std::string arrivalMode = ConfigHandler::GetOption<std::string>("arrivalMode", "");
+    if (!_replay && !arrivalMode.empty())
+    {
+        ArrivalSchedule schedule;
+        if (!ArrivalScheduler::ParseMode(arrivalMode, schedule.mode))
+        {
+            NC_LOG_ERROR("Swarm: Unknown arrival mode %s", arrivalMode.c_str());
+            _isEnabled = false;
+            return;
+        }
+
+        schedule.rate = ConfigHandler::GetOption<f64>("arrivalRate", 100.0);
+        schedule.rateEnd = ConfigHandler::GetOption<f64>("arrivalRateEnd", 1000.0);
+        schedule.rampDuration = ConfigHandler::GetOption<f64>("arrivalRampDuration", 60.0);
+        schedule.stepRate = ConfigHandler::GetOption<f64>("arrivalStepRate", 50.0);
+        schedule.stepInterval = ConfigHandler::GetOption<f64>("arrivalStepInterval", 10.0);
+
+        _useArrivals = true;
+        _arrivals.Start(schedule, _botCount);
+
+        NC_LOG_MESSAGE("Swarm: Starting %u bots with %s arrivals at %.1f sessions per second", _botCount, arrivalMode.c_str(), schedule.rate);
+        return;
+    }
+
+    NC_LOG_MESSAGE("Swarm: Spawning %u bots at %u bots per tick", _botCount, _spawnPerTick);
+}
+
+void BotSwarm::Stop()
+{
+    // Bots are serviced by the io threads, so the close has to go through each bot's strand
+    for (auto& bot : _bots)
+    {
+        NovusConnection* connection = bot.get();
+        asio::post(connection->GetStrand(), [connection]()
+        {
+            if (!connection->IsClosed())
+                connection->Close(asio::error::shut_down);
+        });
+
+        WorldConnection* worldConnection = connection->GetWorldConnection();
+        if (worldConnection)
+        {
+            asio::post(worldConnection->GetStrand(), [worldConnection]()
+            {
+                if (!worldConnection->IsClosed())
+                    worldConnection->Close(asio::error::shut_down);
+            });
+        }
+    }
+}
+
+void BotSwarm::Update()
+{
+    if (!_isEnabled || _useArrivals)
+        return;
+
+    if (_replay)
+    {
+        // Captured bots keep the captured spawn pattern, scaled like the rest of the replay
+        f64 timeScale = _replay->GetTimeScale();
+        f64 elapsed = static_cast<f64>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _replayStart).count());
+        std::vector<ReplayStream> const& streams = _replay->GetStreams();
+
+        for (u32 i = 0; i < _spawnPerTick && _bots.size() < _botCount; i++)
+        {
+            ReplayStream const& stream = streams[_bots.size()];
+            if (timeScale > 0.0 && stream.startTime / timeScale > elapsed)
+                break;
+
+            if (!SpawnBot(stream.botId, &stream))
+                break;
+        }
+        return;
+    }
+
+    for (u32 i = 0; i < _spawnPerTick && _bots.size() < _botCount; i++)
+    {
+        if (!SpawnBot(static_cast<u32>(_bots.size()), nullptr))
+            break;
+    }
+}
+
+void BotSwarm::UpdateArrivals()
+{
+    if (!_isEnabled || !_useArrivals)
+        return;
+
+    _arrivals.Update([this]()
+    {
+        return _bots.size() < _botCount && SpawnBot(static_cast<u32>(_bots.size()), nullptr);
+    });
+}
+
+bool BotSwarm::SpawnBot(u32 botId, ReplayStream const* replayStream)
+{
+    std::string username = _usernamePrefix + std::to_string(botId);
+
+    NovusConnection* connection = new NovusConnection(new asio::ip::tcp::socket(*_ioService), _address, _port, botId);
+    connection->SetReplay(_replay.get(), replayStream);
+    _bots.emplace_back(connection);
+
+    if (!connection->Start(username, _password))
+    {
+        NC_LOG_ERROR("Swarm: Bot %u failed to start, halting spawning", botId);
+        _isEnabled = false;
+        return false;
+    }
+
+    return true;
+}
+
+void BotSwarm::GetStatus(BotSwarmStatus& status) const
+{
+    status = BotSwarmStatus();
+    status.spawned = static_cast<u32>(_bots.size());
+
+    for (auto& bot : _bots)
+    {
+        status.queued += static_cast<u32>(bot->GetSendQueueDepth());
+
+        switch (bot->_status.load())
+        {
+            case NOVUSSTATUS_CONNECTING: status.connecting++; break;
+            case NOVUSSTATUS_CHALLENGE: status.challenge++; break;
+            case NOVUSSTATUS_PROOF: status.proof++; break;
+            case NOVUSSTATUS_AUTHED: status.authed++; break;
+            case NOVUSSTATUS_CLOSED: status.closed++; break;
+        }
+
+        WorldConnection* worldConnection = bot->GetWorldConnection();
+        if (!worldConnection)
+            continue;
+
+        status.queued += static_cast<u32>(worldConnection->GetSendQueueDepth());
+        switch (worldConnection->_status.load())
+        {
+            case WORLDSTATUS_CLOSED: status.worldClosed++; break;
+            case WORLDSTATUS_AUTHED: status.worldAuthed++; break;
+            default: status.worldConnecting++; break;
+        }
+    }
+}
@@ -0,0 +1,93 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <asio.hpp>
+#include "../NovusTypes.h"
+#include "ReplayCapture.h"
+#include "ArrivalScheduler.h"
+
+class NovusConnection;
+
+struct BotSwarmStatus
+{
+    u32 spawned = 0;
+    u32 connecting = 0;
+    u32 challenge = 0;
+    u32 proof = 0;
+    u32 authed = 0;
+    u32 closed = 0;
+    u32 queued = 0;
+    u32 worldConnecting = 0;
+    u32 worldAuthed = 0;
+    u32 worldClosed = 0;
+};
+
+// Spawns and owns a configurable amount of bots that all share the client's io_service. Bots are spawned a fixed amount
+// per tick or, with an arrival mode configured, open loop at a target arrival rate. With a replay file configured
+// there's one bot per captured bot instead, spawned at its captured start time and re-sending its captured world traffic.
+class BotSwarm
+{
+public:
+    BotSwarm();
+    ~BotSwarm();
+
+    void Start(asio::io_service* ioService);
+    void Stop();
+    void Update();
+    // Starts the sessions that came due with arrival scheduling, called far more often than Update to keep arrivals precise
+    void UpdateArrivals();
+
+    bool IsEnabled() const { return _isEnabled; }
+    u32 GetBotCount() const { return _botCount; }
+    void GetStatus(BotSwarmStatus& status) const;
+    ReplayCapture const* GetReplay() const { return _replay.get(); }
+    ArrivalScheduler const* GetArrivalScheduler() const { return _useArrivals ? &_arrivals : nullptr; }
+
+private:
+    bool SpawnBot(u32 botId, ReplayStream const* replayStream);
+
+private:
+    bool _isEnabled;
+    u32 _botCount;
+    u32 _spawnPerTick;
+
+    std::string _usernamePrefix;
+    std::string _password;
+    std::string _address;
+    u16 _port;
+
+    asio::io_service* _ioService;
+    std::vector<std::unique_ptr<NovusConnection>> _bots;
+
+    bool _useArrivals;
+    ArrivalScheduler _arrivals;
+
+    std::unique_ptr<ReplayCapture> _replay;
+    std::chrono::steady_clock::time_point _replayStart;
+};
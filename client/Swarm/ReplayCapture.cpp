@@ -0,0 +1,188 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#include "ReplayCapture.h"
+#include "../Networking/PacketRecorder.h"
+#include "../Networking/Opcode/Opcode.h"
+#include "../Utils/MappedFile.h"
+#include "../Utils/DebugHandler.h"
+#include <algorithm>
+#include <limits>
+#include <zlib.h>
+
+bool ReplayCapture::Load(std::string const& path)
+{
+    MappedFile file;
+    if (!file.Open(path))
+    {
+        NC_LOG_ERROR("Replay: Failed to open %s", path.c_str());
+        return false;
+    }
+
+    u8 const* data = file.GetData();
+    size_t size = file.GetSize();
+
+    if (size < sizeof(PacketCaptureHeader) + sizeof(PacketCaptureFooter))
+    {
+        NC_LOG_ERROR("Replay: %s is not a packet capture", path.c_str());
+        return false;
+    }
+
+    PacketCaptureHeader const* header = reinterpret_cast<PacketCaptureHeader const*>(data);
+    PacketCaptureFooter const* footer = reinterpret_cast<PacketCaptureFooter const*>(data + size - sizeof(PacketCaptureFooter));
+    if (header->magic != PACKET_CAPTURE_MAGIC || header->version != PACKET_CAPTURE_VERSION || footer->magic != PACKET_CAPTURE_MAGIC)
+    {
+        NC_LOG_ERROR("Replay: %s is not a packet capture or was never finished", path.c_str());
+        return false;
+    }
+
+    // Written without additions so a corrupt index can't wrap around and pass
+    if (footer->blockTableOffset > size || footer->blockCount > (size - footer->blockTableOffset) / sizeof(PacketCaptureBlock) ||
+        footer->opcodeTableOffset > size || footer->opcodeCount > (size - footer->opcodeTableOffset) / sizeof(PacketCaptureOpcode) ||
+        footer->blockListOffset > size || footer->blockListCount > (size - footer->blockListOffset) / sizeof(u32))
+    {
+        NC_LOG_ERROR("Replay: %s has a corrupt index", path.c_str());
+        return false;
+    }
+
+    PacketCaptureBlock const* blocks = reinterpret_cast<PacketCaptureBlock const*>(data + footer->blockTableOffset);
+    PacketCaptureOpcode const* opcodes = reinterpret_cast<PacketCaptureOpcode const*>(data + footer->opcodeTableOffset);
+    u32 const* blockLists = reinterpret_cast<u32 const*>(data + footer->blockListOffset);
+
+    // Only blocks holding outbound packets have to be decompressed, the opcode index tells which ones do
+    std::vector<bool> neededBlocks(footer->blockCount, false);
+    for (u32 i = 0; i < footer->opcodeCount; i++)
+    {
+        PacketCaptureOpcode const& opcode = opcodes[i];
+        if (!(opcode.flags & PACKETRECORD_OUTBOUND) || opcode.blockCount > footer->blockListCount || opcode.blockListIndex > footer->blockListCount - opcode.blockCount)
+            continue;
+
+        for (u32 j = 0; j < opcode.blockCount; j++)
+        {
+            u32 blockIndex = blockLists[opcode.blockListIndex + j];
+            if (blockIndex < footer->blockCount)
+                neededBlocks[blockIndex] = true;
+        }
+    }
+
+    _streams.clear();
+    _payloads.clear();
+    _packetCount = 0;
+
+    robin_hood::unordered_map<u32, size_t> streamIndices;
+    std::vector<u64> authTimes;
+    std::vector<u8> raw;
+
+    for (u32 i = 0; i < footer->blockCount; i++)
+    {
+        if (!neededBlocks[i])
+            continue;
+
+        PacketCaptureBlock const& block = blocks[i];
+        if (block.offset > size || block.compressedSize > size - block.offset)
+        {
+            NC_LOG_ERROR("Replay: Block %u of %s is out of bounds", i, path.c_str());
+            return false;
+        }
+
+        if (block.rawSize > PACKET_CAPTURE_MAX_BLOCK_SIZE)
+        {
+            NC_LOG_ERROR("Replay: Block %u of %s claims %u raw bytes, more than a recorder ever writes", i, path.c_str(), block.rawSize);
+            return false;
+        }
+
+        raw.resize(block.rawSize);
+        uLongf rawSize = block.rawSize;
+        if (uncompress(raw.data(), &rawSize, data + block.offset, block.compressedSize) != Z_OK || rawSize != block.rawSize)
+        {
+            NC_LOG_ERROR("Replay: Failed to decompress block %u of %s", i, path.c_str());
+            return false;
+        }
+
+        size_t position = 0;
+        for (u32 j = 0; j < block.recordCount; j++)
+        {
+            if (position + sizeof(PacketRecordHeader) > rawSize)
+                break;
+
+            PacketRecordHeader const* record = reinterpret_cast<PacketRecordHeader const*>(raw.data() + position);
+            u8 const* payload = raw.data() + position + sizeof(PacketRecordHeader);
+            position += sizeof(PacketRecordHeader) + record->size;
+            if (position > rawSize)
+                break;
+
+            if (!(record->flags & PACKETRECORD_OUTBOUND))
+                continue;
+
+            auto itr = streamIndices.find(record->botId);
+            if (itr == streamIndices.end())
+            {
+                itr = streamIndices.emplace(record->botId, _streams.size()).first;
+                _streams.push_back({ record->botId, record->timestamp, {} });
+                authTimes.push_back(std::numeric_limits<u64>::max());
+            }
+
+            ReplayStream& stream = _streams[itr->second];
+            stream.startTime = std::min(stream.startTime, record->timestamp);
+
+            if (!(record->flags & PACKETRECORD_WORLD))
+                continue;
+
+            if (record->opcode == Common::CMSG_AUTH_SESSION)
+            {
+                authTimes[itr->second] = std::min(authTimes[itr->second], record->timestamp);
+                continue;
+            }
+
+            // The delay holds the absolute timestamp until the stream is sorted
+            stream.packets.push_back({ record->timestamp, _payloads.size(), record->size, record->opcode });
+            _payloads.insert(_payloads.end(), payload, payload + record->size);
+        }
+    }
+
+    for (size_t i = 0; i < _streams.size(); i++)
+    {
+        ReplayStream& stream = _streams[i];
+
+        // A bot that never got into the world has nothing to replay
+        if (authTimes[i] == std::numeric_limits<u64>::max())
+        {
+            stream.packets.clear();
+            continue;
+        }
+
+        // Blocks are per io thread and a bot's strand can run on any of them, so its packets have to be put back in order
+        std::stable_sort(stream.packets.begin(), stream.packets.end(), [](ReplayPacket const& a, ReplayPacket const& b) { return a.delay < b.delay; });
+        for (ReplayPacket& packet : stream.packets)
+        {
+            packet.delay = packet.delay > authTimes[i] ? packet.delay - authTimes[i] : 0;
+        }
+
+        _packetCount += stream.packets.size();
+    }
+
+    std::sort(_streams.begin(), _streams.end(), [](ReplayStream const& a, ReplayStream const& b) { return a.startTime < b.startTime; });
+
+    NC_LOG_MESSAGE("Replay: Loaded %u bots and %llu packets from %s", static_cast<u32>(_streams.size()), _packetCount, path.c_str());
+    return true;
+}
\ No newline at end of file
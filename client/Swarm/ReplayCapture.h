@@ -0,0 +1,76 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include "../NovusTypes.h"
+
+struct ReplayPacket
+{
+    // Microseconds between the bot sending CMSG_AUTH_SESSION and this packet in the capture
+    u64 delay;
+    u64 offset;
+    u32 size;
+    u16 opcode;
+};
+
+struct ReplayStream
+{
+    u32 botId;
+    // When the bot sent its first packet, relative to the start of the capture
+    u64 startTime;
+    std::vector<ReplayPacket> packets;
+};
+
+// Outbound world traffic of every bot in a capture written by PacketRecorder. The login itself isn't part of a stream,
+// replayed bots run the handshake live and only the packets they sent after CMSG_AUTH_SESSION are sent again.
+class ReplayCapture
+{
+public:
+    ReplayCapture() : _timeScale(1.0), _packetCount(0), _sentPackets(0) { }
+
+    bool Load(std::string const& path);
+
+    // 1 keeps the captured timing, 10 replays ten times as fast and 0 sends everything as fast as possible
+    void SetTimeScale(f64 timeScale) { _timeScale = timeScale; }
+    f64 GetTimeScale() const { return _timeScale; }
+
+    // Sorted by start time
+    std::vector<ReplayStream> const& GetStreams() const { return _streams; }
+    u8 const* GetPayload(ReplayPacket const& packet) const { return _payloads.data() + packet.offset; }
+
+    u64 GetPacketCount() const { return _packetCount; }
+    u64 GetSentPackets() const { return _sentPackets.load(std::memory_order_relaxed); }
+    void OnPacketSent() const { _sentPackets.fetch_add(1, std::memory_order_relaxed); }
+
+private:
+    f64 _timeScale;
+    std::vector<ReplayStream> _streams;
+    // Payloads of all streams back to back, the capture itself is compressed so they can't be referenced in place
+    std::vector<u8> _payloads;
+    u64 _packetCount;
+    mutable std::atomic<u64> _sentPackets;
+};
\ No newline at end of file
@@ -0,0 +1,124 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+
+#include "LatencyHistogram.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+static u32 GetHighestBit(u64 value)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return index;
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+    Reset();
+}
+
+void LatencyHistogram::Record(u64 value)
+{
+    _buckets[GetBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    _count.fetch_add(1, std::memory_order_relaxed);
+    _sum.fetch_add(value, std::memory_order_relaxed);
+
+    u64 max = _max.load(std::memory_order_relaxed);
+    while (value > max && !_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) { }
+}
+
+void LatencyHistogram::Reset()
+{
+    for (std::atomic<u64>& bucket : _buckets)
+        bucket.store(0, std::memory_order_relaxed);
+
+    _count.store(0, std::memory_order_relaxed);
+    _sum.store(0, std::memory_order_relaxed);
+    _max.store(0, std::memory_order_relaxed);
+}
+
+u32 LatencyHistogram::GetBucketIndex(u64 value)
+{
+    // The first power of two range is linear
+    if (value < SUB_BUCKET_COUNT)
+        return static_cast<u32>(value);
+
+    u32 highestBit = GetHighestBit(value);
+    u32 shift = highestBit - SUB_BUCKET_BITS;
+    u32 index = (shift + 1) * SUB_BUCKET_COUNT + static_cast<u32>((value >> shift) & (SUB_BUCKET_COUNT - 1));
+
+    return index < BUCKET_COUNT ? index : BUCKET_COUNT - 1;
+}
+
+u64 LatencyHistogram::GetBucketUpperBound(u32 index)
+{
+    if (index < SUB_BUCKET_COUNT)
+        return index;
+
+    u32 shift = index / SUB_BUCKET_COUNT - 1;
+    u64 subBucket = SUB_BUCKET_COUNT + (index % SUB_BUCKET_COUNT);
+    return ((subBucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::GetSummary(LatencySummary& summary) const
+{
+    // Copy the buckets first so the percentiles are computed from one consistent count
+    std::array<u64, BUCKET_COUNT> buckets;
+    u64 count = 0;
+    for (u32 i = 0; i < BUCKET_COUNT; i++)
+    {
+        buckets[i] = _buckets[i].load(std::memory_order_relaxed);
+        count += buckets[i];
+    }
+
+    summary = LatencySummary();
+    summary.count = count;
+    summary.max = _max.load(std::memory_order_relaxed);
+    if (count == 0)
+        return;
+
+    summary.mean = static_cast<f64>(_sum.load(std::memory_order_relaxed)) / static_cast<f64>(count);
+
+    const f64 percentiles[] = { 0.5, 0.9, 0.99, 0.999 };
+    u64* results[] = { &summary.p50, &summary.p90, &summary.p99, &summary.p999 };
+
+    u64 cumulative = 0;
+    u32 percentile = 0;
+    for (u32 i = 0; i < BUCKET_COUNT && percentile < 4; i++)
+    {
+        cumulative += buckets[i];
+        while (percentile < 4 && cumulative >= static_cast<u64>(percentiles[percentile] * count + 0.5) && cumulative > 0)
+        {
+            u64 upperBound = GetBucketUpperBound(i);
+            *results[percentile] = upperBound < summary.max ? upperBound : summary.max;
+            percentile++;
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include <array>
+#include <atomic>
+#include "../NovusTypes.h"
+
+struct LatencySummary
+{
+    u64 count = 0;
+    f64 mean = 0;
+    u64 p50 = 0;
+    u64 p90 = 0;
+    u64 p99 = 0;
+    u64 p999 = 0;
+    u64 max = 0;
+};
+
+// Log bucketed histogram in the style of HdrHistogram, every power of two is split into 16 linear sub buckets
+// which keeps the error of a recorded value below ~6%. Recording is a relaxed atomic add so any thread can record into it.
+class LatencyHistogram
+{
+public:
+    static constexpr u32 SUB_BUCKET_BITS = 4;
+    static constexpr u32 SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    // Enough buckets for values up to 2^40, anything above lands in the last bucket
+    static constexpr u32 BUCKET_COUNT = (40 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+    LatencyHistogram();
+
+    void Record(u64 value);
+    void Reset();
+
+    // Percentiles report the highest value that is equivalent to the bucket they fall into, capped at the recorded max
+    void GetSummary(LatencySummary& summary) const;
+
+    static u32 GetBucketIndex(u64 value);
+    static u64 GetBucketUpperBound(u32 index);
+
+private:
+    std::array<std::atomic<u64>, BUCKET_COUNT> _buckets;
+    std::atomic<u64> _count;
+    std::atomic<u64> _sum;
+    std::atomic<u64> _max;
+};
\ No newline at end of file
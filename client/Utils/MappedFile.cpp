@@ -0,0 +1,133 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+MappedFile::MappedFile() : _data(nullptr), _size(0), _file(INVALID_HANDLE_VALUE), _mapping(nullptr) { }
+#else
+MappedFile::MappedFile() : _data(nullptr), _size(0), _file(-1) { }
+#endif
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+#if defined(_WIN32)
+bool MappedFile::Open(std::string const& path)
+{
+    Close();
+
+    _file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (_file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(_file, &size) || size.QuadPart == 0)
+    {
+        Close();
+        return false;
+    }
+
+    _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!_mapping)
+    {
+        Close();
+        return false;
+    }
+
+    _data = static_cast<u8 const*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!_data)
+    {
+        Close();
+        return false;
+    }
+
+    _size = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (_data)
+        UnmapViewOfFile(_data);
+    if (_mapping)
+        CloseHandle(_mapping);
+    if (_file != INVALID_HANDLE_VALUE)
+        CloseHandle(_file);
+
+    _data = nullptr;
+    _size = 0;
+    _mapping = nullptr;
+    _file = INVALID_HANDLE_VALUE;
+}
+#else
+bool MappedFile::Open(std::string const& path)
+{
+    Close();
+
+    _file = open(path.c_str(), O_RDONLY);
+    if (_file < 0)
+        return false;
+
+    struct stat fileStat;
+    if (fstat(_file, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        Close();
+        return false;
+    }
+
+    void* data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, _file, 0);
+    if (data == MAP_FAILED)
+    {
+        Close();
+        return false;
+    }
+
+    _data = static_cast<u8 const*>(data);
+    _size = static_cast<size_t>(fileStat.st_size);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (_data)
+        munmap(const_cast<u8*>(_data), _size);
+    if (_file >= 0)
+        close(_file);
+
+    _data = nullptr;
+    _size = 0;
+    _file = -1;
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,153 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+
+#include "TickScheduler.h"
+#include <algorithm>
+#include <thread>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <cerrno>
+#include <time.h>
+#endif
+
+TickScheduler::TickScheduler(f64 tickRate) : _tickRate(tickRate > 0.0 ? tickRate : 30.0), _policy(TICK_OVERRUN_CATCH_UP), _maxCatchUpTicks(5),
+    _ticks(0), _overruns(0), _skippedTicks(0)
+{
+    _period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<f64>(1.0 / _tickRate));
+    _startTime = _deadline = _tickStart = Clock::now();
+}
+
+bool TickScheduler::ParsePolicy(std::string const& name, TickOverrunPolicy& policy)
+{
+    if (name == "catchup")
+        policy = TICK_OVERRUN_CATCH_UP;
+    else if (name == "skip")
+        policy = TICK_OVERRUN_SKIP;
+    else
+        return false;
+
+    return true;
+}
+
+char const* TickScheduler::GetPolicyName(TickOverrunPolicy policy)
+{
+    return policy == TICK_OVERRUN_SKIP ? "skip" : "catchup";
+}
+
+void TickScheduler::SetOverrunPolicy(TickOverrunPolicy policy, u32 maxCatchUpTicks)
+{
+    _policy = policy;
+    _maxCatchUpTicks = maxCatchUpTicks;
+}
+
+void TickScheduler::Start()
+{
+    _startTime = Clock::now();
+    _deadline = _startTime;
+    _ticks = 0;
+    _overruns = 0;
+    _skippedTicks = 0;
+    _tickDuration.Reset();
+    _tickLateness.Reset();
+}
+
+void TickScheduler::BeginTick()
+{
+    _tickStart = Clock::now();
+    _tickLateness.Record(std::chrono::duration_cast<std::chrono::microseconds>(_tickStart - std::min(_tickStart, _deadline)).count());
+    _ticks++;
+}
+
+void TickScheduler::EndTick()
+{
+    Clock::time_point now = Clock::now();
+    _tickDuration.Record(std::chrono::duration_cast<std::chrono::microseconds>(now - _tickStart).count());
+
+    _deadline += _period;
+    if (now <= _deadline)
+        return;
+
+    _overruns++;
+
+    // Whole periods the schedule is behind, the tick due right now is not counted
+    u64 behind = static_cast<u64>((now - _deadline) / _period);
+    u64 allowed = _policy == TICK_OVERRUN_CATCH_UP ? _maxCatchUpTicks : 0;
+    if (behind > allowed)
+    {
+        // Dropped ticks keep the phase of the schedule so later deadlines stay multiples of the period from the start
+        u64 skipped = behind - allowed;
+        _deadline += _period * skipped;
+        _skippedTicks += skipped;
+    }
+}
+
+f64 TickScheduler::GetMeasuredRate() const
+{
+    f64 elapsed = std::chrono::duration<f64>(Clock::now() - _startTime).count();
+    return elapsed > 0.0 ? _ticks / elapsed : 0.0;
+}
+
+void TickScheduler::SleepUntil(Clock::time_point deadline)
+{
+#if defined(_WIN32)
+    // Waitable timers only take absolute times on the wall clock, so the monotonic deadline is turned into a relative one
+    // right before waiting. High resolution timers avoid rounding every sleep up to the 15.6ms system timer.
+    thread_local HANDLE timer = nullptr;
+    if (!timer)
+    {
+#if defined(CREATE_WAITABLE_TIMER_HIGH_RESOLUTION)
+        timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+#endif
+        if (!timer)
+            timer = CreateWaitableTimerW(nullptr, TRUE, nullptr);
+    }
+
+    Clock::time_point now = Clock::now();
+    if (now >= deadline)
+        return;
+
+    LARGE_INTEGER dueTime;
+    dueTime.QuadPart = -static_cast<LONGLONG>(std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now).count() / 100);
+    if (!timer || dueTime.QuadPart == 0 || !SetWaitableTimer(timer, &dueTime, 0, nullptr, nullptr, FALSE))
+    {
+        std::this_thread::sleep_until(deadline);
+        return;
+    }
+
+    WaitForSingleObject(timer, INFINITE);
+#elif defined(__linux__)
+    // steady_clock is CLOCK_MONOTONIC, sleeping to an absolute time can't oversleep because of how long we took to get here
+    std::chrono::nanoseconds sinceEpoch = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch());
+
+    timespec time;
+    time.tv_sec = static_cast<time_t>(sinceEpoch.count() / 1000000000);
+    time.tv_nsec = static_cast<long>(sinceEpoch.count() % 1000000000);
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &time, nullptr) == EINTR) { }
+#else
+    std::this_thread::sleep_until(deadline);
+#endif
+}
\ No newline at end of file
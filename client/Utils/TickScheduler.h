@@ -0,0 +1,106 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include <chrono>
+#include <string>
+#include "../NovusTypes.h"
+#include "LatencyHistogram.h"
+
+enum TickOverrunPolicy
+{
+    // Late ticks run back to back until the schedule is met again, up to maxCatchUpTicks behind
+    TICK_OVERRUN_CATCH_UP,
+    // Ticks that were missed entirely are dropped, only the one currently due still runs late
+    TICK_OVERRUN_SKIP
+};
+
+// Fixed timestep scheduler for the tick thread. Tick deadlines are absolute points on the monotonic clock, start plus
+// a whole number of periods, so time spent ticking or oversleeping never accumulates into drift, and the thread sleeps
+// on the OS timer until a deadline instead of spinning. How late every tick started and how long it ran is recorded
+// in microseconds so the tick rate under load can be checked instead of assumed.
+class TickScheduler
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    TickScheduler(f64 tickRate);
+
+    static bool ParsePolicy(std::string const& name, TickOverrunPolicy& policy);
+    static char const* GetPolicyName(TickOverrunPolicy policy);
+
+    void SetOverrunPolicy(TickOverrunPolicy policy, u32 maxCatchUpTicks);
+    void Start();
+
+    void BeginTick();
+    void EndTick();
+
+    // Sleeps until the next tick is due, calling idle at least every idleInterval while waiting if one is given
+    template <typename Idle>
+    void WaitForTick(Clock::duration idleInterval, Idle idle)
+    {
+        for (Clock::time_point now = Clock::now(); now < _deadline; now = Clock::now())
+        {
+            if (idleInterval <= Clock::duration::zero())
+            {
+                SleepUntil(_deadline);
+                continue;
+            }
+
+            SleepUntil(std::min(_deadline, now + idleInterval));
+            idle();
+        }
+    }
+
+    // Blocks the calling thread until the monotonic clock reaches deadline
+    static void SleepUntil(Clock::time_point deadline);
+
+    f64 GetTickRate() const { return _tickRate; }
+    // Ticks per second actually achieved since Start
+    f64 GetMeasuredRate() const;
+    TickOverrunPolicy GetOverrunPolicy() const { return _policy; }
+    u64 GetTicks() const { return _ticks; }
+    u64 GetOverruns() const { return _overruns; }
+    u64 GetSkippedTicks() const { return _skippedTicks; }
+    void GetTickDuration(LatencySummary& summary) const { _tickDuration.GetSummary(summary); }
+    void GetTickLateness(LatencySummary& summary) const { _tickLateness.GetSummary(summary); }
+
+private:
+    f64 _tickRate;
+    Clock::duration _period;
+    TickOverrunPolicy _policy;
+    u32 _maxCatchUpTicks;
+
+    Clock::time_point _startTime;
+    Clock::time_point _deadline;
+    Clock::time_point _tickStart;
+
+    u64 _ticks;
+    // Ticks whose work ran past the deadline of the next one
+    u64 _overruns;
+    u64 _skippedTicks;
+
+    LatencyHistogram _tickDuration;
+    LatencyHistogram _tickLateness;
+};
\ No newline at end of file
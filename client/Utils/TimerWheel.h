@@ -0,0 +1,99 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include "../NovusTypes.h"
+
+// Hashed timer wheel, deadlines are bucketed into slots of a fixed resolution so scheduling and firing are constant time
+// no matter how many timers are pending. Deadlines further out than one rotation share a slot with nearer ones and are
+// skipped until their rotation comes around. Not thread safe, the owner advances it from a single thread.
+template <typename T>
+class TimerWheel
+{
+public:
+    TimerWheel(u64 resolution, size_t slotCount) : _slots(slotCount), _resolution(resolution), _mask(slotCount - 1), _currentTick(0), _size(0)
+    {
+        assert(resolution > 0 && slotCount > 0 && (slotCount & (slotCount - 1)) == 0);
+    }
+
+    // Deadlines that already passed fire on the next Advance
+    void Schedule(u64 deadline, T const& value)
+    {
+        u64 tick = std::max(deadline / _resolution, _currentTick);
+        _slots[tick & _mask].push_back({ tick, value });
+        _size++;
+    }
+
+    // Fires every timer with a deadline up to now, in slot order
+    template <typename Callback>
+    void Advance(u64 now, Callback callback)
+    {
+        u64 targetTick = now / _resolution;
+
+        for (; _currentTick <= targetTick; _currentTick++)
+        {
+            if (_size == 0)
+            {
+                _currentTick = targetTick + 1;
+                break;
+            }
+
+            std::vector<Entry>& slot = _slots[_currentTick & _mask];
+            for (size_t i = 0; i < slot.size();)
+            {
+                if (slot[i].tick > _currentTick)
+                {
+                    i++;
+                    continue;
+                }
+
+                T value = slot[i].value;
+                slot[i] = slot.back();
+                slot.pop_back();
+                _size--;
+
+                callback(value);
+            }
+        }
+    }
+
+    size_t Size() const { return _size; }
+    bool Empty() const { return _size == 0; }
+
+private:
+    struct Entry
+    {
+        u64 tick;
+        T value;
+    };
+
+    std::vector<std::vector<Entry>> _slots;
+    u64 _resolution;
+    size_t _mask;
+    u64 _currentTick;
+    size_t _size;
+};
\ No newline at end of file
@@ -5,12 +5,18 @@
 #include <asio.hpp>
 
 #include "Connection/NovusConnection.h"
+#include "Connection/AuthTimings.h"
+#include "Networking/IOThreadPool.h"
+#include "Networking/PacketRecorder.h"
 #include "Config/ConfigHandler.h"
 #include "Utils/DebugHandler.h"
 
 #include "ConsoleCommands.h"
 #include "ClientHandler.h"
 
+// Milliseconds the io threads get to finish closing connections on exit
+constexpr u32 SHUTDOWN_DRAIN_TIMEOUT = 2000;
+
 std::string GetLineFromCin() 
 {
     std::string line;
@@ -27,16 +33,20 @@ i32 main()
         return 0;
     }
 
+    u32 ioThreadCount = IOThreadPool::GetThreadCount(ConfigHandler::GetOption<u32>("ioThreads", 0));
+
+	// The io_service has to outlive the ClientHandler since the swarm owns sockets bound to it
+	asio::io_service io_service(ioThreadCount);
     ClientHandler clientHandler(ConfigHandler::GetOption<f32>("tickRate", 30));
 
-	asio::io_service io_service(2);
     srand((u32)time(NULL));
 
-    std::thread run_thread([&]
-    {
-        auto work = std::make_shared<asio::io_service::work>(io_service);
-        io_service.run();
-    });
+    std::string packetCaptureFile = ConfigHandler::GetOption<std::string>("packetCaptureFile", "");
+    if (!packetCaptureFile.empty())
+        PacketRecorder::Start(packetCaptureFile, ConfigHandler::GetOption<u32>("packetCaptureBlockSize", 1048576));
+
+    IOThreadPool ioThreadPool(io_service);
+    ioThreadPool.Start(ioThreadCount);
 
 	clientHandler.SetIOService(&io_service);
 	clientHandler.Start();
@@ -59,8 +69,8 @@ i32 main()
             }
             if (message.code == MSG_OUT_PRINT)
             {
-                NC_LOG_MESSAGE(*message.message);
-                delete message.message;
+                NC_LOG_MESSAGE("%s", message.GetText());
+                message.Release();
             }
         }
 
@@ -84,11 +94,11 @@ i32 main()
         }
     }
 
-    io_service.stop();
-    while (!io_service.stopped())
-    {
-        std::this_thread::yield();
-    }
+    // The swarm posted a close to every bot on the way out, let those run so connections shut down cleanly
+    ioThreadPool.Stop(std::chrono::milliseconds(SHUTDOWN_DRAIN_TIMEOUT));
+    PacketRecorder::Stop();
+
+    AuthTimings::Print([](char const* format, auto... args) { NC_LOG_MESSAGE(format, args...); });
 
     return 0;
 }
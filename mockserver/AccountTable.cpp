@@ -0,0 +1,131 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+
+#include "AccountTable.h"
+#include "Cryptography/SHA1.h"
+#include <cstring>
+#include <mutex>
+
+AccountTable::AccountTable() : _N(), _g(7), _autoCreate(false), _defaultPassword(), _mutex(), _accounts(), _sessionKeyMutex(), _sessionKeys()
+{
+    _N.Hex2BN("894B645E89E1535BBDAD5B8B290650530801B18EBFBF5E8FAB3C82872A3E9BB7");
+}
+
+void AccountTable::Populate(std::string const& usernamePrefix, std::string const& password, u32 count)
+{
+    _accounts.reserve(_accounts.size() + count);
+    for (u32 i = 0; i < count; i++)
+    {
+        AddAccount(usernamePrefix + std::to_string(i), password);
+    }
+}
+
+void AccountTable::AddAccount(std::string const& username, std::string const& password)
+{
+    MockAccount account;
+    CreateAccount(username, password, account);
+
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    _accounts[username] = account;
+}
+
+bool AccountTable::GetAccount(std::string const& username, MockAccount& account)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        auto itr = _accounts.find(username);
+        if (itr != _accounts.end())
+        {
+            account = itr->second;
+            return true;
+        }
+    }
+
+    if (!_autoCreate)
+        return false;
+
+    CreateAccount(username, _defaultPassword, account);
+
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    _accounts.emplace(username, account);
+    return true;
+}
+
+void AccountTable::SetAutoCreate(bool autoCreate, std::string const& defaultPassword)
+{
+    _autoCreate = autoCreate;
+    _defaultPassword = defaultPassword;
+}
+
+size_t AccountTable::GetAccountCount()
+{
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    return _accounts.size();
+}
+
+void AccountTable::SetSessionKey(std::string const& username, BigNumber& sessionKey)
+{
+    SessionKey key;
+    std::memcpy(key.data, sessionKey.BN2BinArray(sizeof(key.data)).get(), sizeof(key.data));
+
+    std::lock_guard<std::mutex> lock(_sessionKeyMutex);
+    _sessionKeys[username] = key;
+}
+
+bool AccountTable::GetSessionKey(std::string const& username, BigNumber& sessionKey)
+{
+    std::lock_guard<std::mutex> lock(_sessionKeyMutex);
+    auto itr = _sessionKeys.find(username);
+    if (itr == _sessionKeys.end())
+        return false;
+
+    sessionKey.Bin2BN(itr->second.data, sizeof(itr->second.data));
+    return true;
+}
+
+void AccountTable::CreateAccount(std::string const& username, std::string const& password, MockAccount& account)
+{
+    // Has to mirror how the client derives x in NovusConnection::HandleCommandChallenge
+    SHA1Hasher sha;
+    sha.UpdateHash(username + ":" + password);
+    sha.Finish();
+
+    BigNumber passwordKey;
+    passwordKey.Bin2BN(sha.GetData(), 20);
+
+    BigNumber salt;
+    salt.Rand(32 * 8);
+
+    sha.Init();
+    sha.UpdateHashForBn(2, &salt, &passwordKey);
+    sha.Finish();
+
+    BigNumber x;
+    x.Bin2BN(sha.GetData(), 20);
+
+    BigNumber verifier = _g.ModExponential(x, _N);
+
+    std::memcpy(account.salt, salt.BN2BinArray(32).get(), 32);
+    std::memcpy(account.verifier, verifier.BN2BinArray(32).get(), 32);
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <robin_hood.h>
+#include "NovusTypes.h"
+#include "Cryptography/BigNumber.h"
+
+// Salt and verifier are kept as raw little endian bytes, exactly how they are used on the wire
+struct MockAccount
+{
+    u8 salt[32];
+    u8 verifier[32];
+};
+
+// In-memory replacement for the authserver's account database
+class AccountTable
+{
+public:
+    AccountTable();
+
+    // Creates accounts named prefix0 to prefix(count - 1) that all share the same password
+    void Populate(std::string const& usernamePrefix, std::string const& password, u32 count);
+    void AddAccount(std::string const& username, std::string const& password);
+
+    // Unknown usernames are created on the fly with the default password when auto creation is enabled
+    bool GetAccount(std::string const& username, MockAccount& account);
+    void SetAutoCreate(bool autoCreate, std::string const& defaultPassword);
+
+    size_t GetAccountCount();
+
+    // Session keys are handed from the auth session to the world session like the real servers do through the database
+    void SetSessionKey(std::string const& username, BigNumber& sessionKey);
+    bool GetSessionKey(std::string const& username, BigNumber& sessionKey);
+
+    BigNumber const& GetN() const { return _N; }
+    BigNumber const& GetG() const { return _g; }
+
+private:
+    void CreateAccount(std::string const& username, std::string const& password, MockAccount& account);
+
+    BigNumber _N;
+    BigNumber _g;
+
+    bool _autoCreate;
+    std::string _defaultPassword;
+
+    std::shared_mutex _mutex;
+    robin_hood::unordered_flat_map<std::string, MockAccount> _accounts;
+
+    struct SessionKey
+    {
+        u8 data[40];
+    };
+    std::mutex _sessionKeyMutex;
+    robin_hood::unordered_flat_map<std::string, SessionKey> _sessionKeys;
+};
\ No newline at end of file
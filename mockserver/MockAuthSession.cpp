@@ -0,0 +1,282 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+
+#include "MockAuthSession.h"
+#include "Connection/NovusConnection.h"
+#include "Cryptography/SHA1.h"
+#include "Utils/DebugHandler.h"
+#include <cstring>
+
+MockAuthSession::MockAuthSession(asio::ip::tcp::socket* socket, AccountTable& accountTable, MockServerStats& stats, std::vector<u8> const& realmListPacket, u32 processingDelay)
+    : MockSession(socket, stats, processingDelay), _accountTable(accountTable), _realmListPacket(realmListPacket), _status(MOCKSTATUS_CHALLENGE), _username(), _account(), _b(), _B() { }
+
+void MockAuthSession::HandleRead()
+{
+    RingBuffer& receiveBuffer = GetReceiveBuffer();
+    while (receiveBuffer.GetActualSize())
+    {
+        u8 command = receiveBuffer.PeekAt<u8>(0);
+
+        size_t size = 0;
+        if (command == NOVUS_CHALLENGE && _status == MOCKSTATUS_CHALLENGE)
+        {
+            // The challenge carries its own size after the command and error bytes
+            if (receiveBuffer.GetActualSize() < 4)
+                break;
+
+            size = 4 + receiveBuffer.PeekAt<u16>(2);
+            if (size < 34 || size > sizeof(cAuthLogonChallenge))
+            {
+                Close(asio::error::message_size);
+                return;
+            }
+        }
+        else if (command == NOVUS_PROOF && _status == MOCKSTATUS_PROOF)
+        {
+            size = sizeof(cAuthLogonProof);
+        }
+        else if (command == NOVUS_REALM_LIST && _status == MOCKSTATUS_AUTHED)
+        {
+            size = sizeof(cAuthRealmList);
+        }
+        else
+        {
+            Close(asio::error::shut_down);
+            return;
+        }
+
+        if (receiveBuffer.GetActualSize() < size)
+            break;
+
+        if (!receiveBuffer.Linearize(size))
+        {
+            Close(asio::error::message_size);
+            return;
+        }
+
+        bool result = false;
+        switch (command)
+        {
+            case NOVUS_CHALLENGE: result = HandleCommandChallenge(); break;
+            case NOVUS_PROOF: result = HandleCommandProof(); break;
+            case NOVUS_REALM_LIST: result = HandleCommandRealmList(); break;
+        }
+        if (!result)
+        {
+            _stats.failed++;
+            if (_isClosed)
+                return;
+
+            // Keep reading so we notice the client closing after it got the failure
+            _status = MOCKSTATUS_FAILED;
+        }
+
+        receiveBuffer.ReadBytes(size);
+    }
+
+    AsyncRead();
+}
+
+bool MockAuthSession::HandleCommandChallenge()
+{
+    cAuthLogonChallenge* logonChallenge = reinterpret_cast<cAuthLogonChallenge*>(GetReceiveBuffer().GetReadPointer());
+    _stats.challenges++;
+
+    u8 usernameLength = logonChallenge->username_length;
+    if (usernameLength > sizeof(logonChallenge->username) || 34u + usernameLength > 4u + logonChallenge->size)
+    {
+        Close(asio::error::message_size);
+        return false;
+    }
+    _username.assign(logonChallenge->username, usernameLength);
+
+    if (!_accountTable.GetAccount(_username, _account))
+    {
+        // Failed challenges are just the 3 byte header, the client closes on its own after reading it
+        ByteBuffer packet(3);
+        packet.Write<u8>(NOVUS_CHALLENGE);
+        packet.Write<u8>(0);
+        packet.Write<u8>(AUTH_FAIL_UNKNOWN_ACCOUNT);
+        SendResponse(std::move(packet));
+        return false;
+    }
+
+    BigNumber N = _accountTable.GetN();
+    BigNumber g = _accountTable.GetG();
+    BigNumber verifier, k(3);
+    verifier.Bin2BN(_account.verifier, 32);
+
+    _b.Rand(19 * 8);
+    BigNumber gmod = g.ModExponential(_b, N);
+    _B = ((verifier * k) + gmod) % N;
+
+    sAuthLogonChallengeData challengeData;
+    challengeData.command = NOVUS_CHALLENGE;
+    challengeData.error = 0;
+    challengeData.result = AUTH_SUCCESS;
+    std::memcpy(challengeData.b, _B.BN2BinArray(32).get(), 32);
+    challengeData.g_length = 1;
+    challengeData.g = u8(g.GetUInt32());
+    challengeData.n_length = 32;
+    std::memcpy(challengeData.n, N.BN2BinArray(32).get(), 32);
+    std::memcpy(challengeData.salt, _account.salt, 32);
+
+    BigNumber versionChallenge;
+    versionChallenge.Rand(16 * 8);
+    std::memcpy(challengeData.version_challenge, versionChallenge.BN2BinArray(16).get(), 16);
+    challengeData.security_flags = 0;
+
+    ByteBuffer packet(sizeof(sAuthLogonChallengeData));
+    packet.Append(reinterpret_cast<u8 const*>(&challengeData), sizeof(sAuthLogonChallengeData));
+
+    _status = MOCKSTATUS_PROOF;
+    SendResponse(std::move(packet));
+    return true;
+}
+
+bool MockAuthSession::HandleCommandProof()
+{
+    cAuthLogonProof* logonProof = reinterpret_cast<cAuthLogonProof*>(GetReceiveBuffer().GetReadPointer());
+
+    BigNumber N = _accountTable.GetN();
+    BigNumber g = _accountTable.GetG();
+    BigNumber A, u, S, M, salt, verifier;
+    A.Bin2BN(logonProof->A, 32);
+    salt.Bin2BN(_account.salt, 32);
+    verifier.Bin2BN(_account.verifier, 32);
+
+    if ((A % N).IsZero())
+    {
+        Close(asio::error::shut_down);
+        return false;
+    }
+
+    SHA1Hasher sha;
+    sha.UpdateHashForBn(2, &A, &_B);
+    sha.Finish();
+    u.Bin2BN(sha.GetData(), 20);
+
+    S = (A * verifier.ModExponential(u, N)).ModExponential(_b, N);
+
+    // Interleaved session key, the same as the client derives it
+    u8 t[32];
+    u8 t1[16];
+    u8 vK[40];
+    std::memcpy(t, S.BN2BinArray(32).get(), 32);
+
+    for (i32 i = 0; i < 16; ++i)
+        t1[i] = t[i * 2];
+
+    sha.Init();
+    sha.UpdateHash(t1, 16);
+    sha.Finish();
+
+    for (i32 i = 0; i < 20; ++i)
+        vK[i * 2] = sha.GetData()[i];
+
+    for (i32 i = 0; i < 16; ++i)
+        t1[i] = t[i * 2 + 1];
+
+    sha.Init();
+    sha.UpdateHash(t1, 16);
+    sha.Finish();
+
+    for (i32 i = 0; i < 20; ++i)
+        vK[i * 2 + 1] = sha.GetData()[i];
+
+    BigNumber K;
+    K.Bin2BN(vK, 40);
+
+    u8 hash[20];
+    sha.Init();
+    sha.UpdateHashForBn(1, &N);
+    sha.Finish();
+    std::memcpy(hash, sha.GetData(), 20);
+
+    sha.Init();
+    sha.UpdateHashForBn(1, &g);
+    sha.Finish();
+
+    for (i32 i = 0; i < 20; ++i)
+        hash[i] ^= sha.GetData()[i];
+
+    BigNumber t3;
+    t3.Bin2BN(hash, 20);
+
+    sha.Init();
+    sha.UpdateHash(_username);
+    sha.Finish();
+
+    u8 t4[SHA_DIGEST_LENGTH];
+    std::memcpy(t4, sha.GetData(), SHA_DIGEST_LENGTH);
+
+    sha.Init();
+    sha.UpdateHashForBn(1, &t3);
+    sha.UpdateHash(t4, SHA_DIGEST_LENGTH);
+    sha.UpdateHashForBn(4, &salt, &A, &_B, &K);
+    sha.Finish();
+
+    M.Bin2BN(sha.GetData(), 20);
+    if (std::memcmp(M.BN2BinArray(20).get(), logonProof->M1, 20) != 0)
+    {
+        ByteBuffer packet(4);
+        packet.Write<u8>(NOVUS_PROOF);
+        packet.Write<u8>(AUTH_FAIL_INCORRECT_PASSWORD);
+        packet.Write<u16>(0);
+        SendResponse(std::move(packet));
+        return false;
+    }
+
+    sha.Init();
+    sha.UpdateHashForBn(3, &A, &M, &K);
+    sha.Finish();
+
+    sAuthLogonProofData proofData;
+    proofData.cmd = NOVUS_PROOF;
+    proofData.error = 0;
+    std::memcpy(proofData.M2, sha.GetData(), 20);
+    proofData.AccountFlags = 0x00800000;
+    proofData.SurveyId = 0;
+    proofData.LoginFlags = 0;
+
+    ByteBuffer packet(sizeof(sAuthLogonProofData));
+    packet.Append(reinterpret_cast<u8 const*>(&proofData), sizeof(sAuthLogonProofData));
+
+    _accountTable.SetSessionKey(_username, K);
+
+    _status = MOCKSTATUS_AUTHED;
+    _stats.authed++;
+    SendResponse(std::move(packet));
+    return true;
+}
+
+bool MockAuthSession::HandleCommandRealmList()
+{
+    _stats.realmLists++;
+
+    ByteBuffer packet(_realmListPacket.size());
+    packet.Append(_realmListPacket.data(), _realmListPacket.size());
+    SendResponse(std::move(packet));
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <asio.hpp>
+#include "NovusTypes.h"
+#include "MockSession.h"
+#include "Cryptography/BigNumber.h"
+#include "AccountTable.h"
+
+enum MockSessionStatus
+{
+    MOCKSTATUS_CHALLENGE    = 0,
+    MOCKSTATUS_PROOF        = 1,
+    MOCKSTATUS_AUTHED       = 2,
+    MOCKSTATUS_FAILED       = 3
+};
+
+// Server side of the logon protocol for a single client connection
+class MockAuthSession : public MockSession
+{
+public:
+    MockAuthSession(asio::ip::tcp::socket* socket, AccountTable& accountTable, MockServerStats& stats, std::vector<u8> const& realmListPacket, u32 processingDelay);
+
+    void HandleRead() override;
+
+private:
+    bool HandleCommandChallenge();
+    bool HandleCommandProof();
+    bool HandleCommandRealmList();
+
+private:
+    AccountTable& _accountTable;
+    std::vector<u8> const& _realmListPacket;
+
+    MockSessionStatus _status;
+
+    std::string _username;
+    MockAccount _account;
+    BigNumber _b;
+    BigNumber _B;
+};
\ No newline at end of file
@@ -0,0 +1,203 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+
+#include "MockServer.h"
+#include "Connection/NovusConnection.h"
+#include "Utils/DebugHandler.h"
+
+constexpr u32 SWEEP_INTERVAL = 1000;
+
+MockServer::MockServer(asio::io_service& ioService, AccountTable& accountTable)
+    : _ioService(ioService), _strand(ioService), _acceptor(ioService), _worldAcceptor(ioService), _sweepTimer(ioService), _accountTable(accountTable), _processingDelay(0), _worldBulkPacketSize(0), _stats(), _realms(), _realmListPacket(), _sessionMutex(), _sessions(), _finishedSessions() { }
+
+MockServer::~MockServer()
+{
+}
+
+bool MockServer::Start(std::string const& address, u16 port, u16 worldPort, u32 processingDelay)
+{
+    _processingDelay = processingDelay;
+    BuildRealmListPacket();
+
+    if (!Listen(_acceptor, address, port) || !Listen(_worldAcceptor, address, worldPort))
+        return false;
+
+    AsyncAccept(false);
+    AsyncAccept(true);
+    ScheduleSweep();
+    return true;
+}
+
+bool MockServer::Listen(asio::ip::tcp::acceptor& acceptor, std::string const& address, u16 port)
+{
+    asio::error_code error;
+    asio::ip::tcp::endpoint endpoint(asio::ip::make_address(address, error), port);
+    if (error)
+    {
+        NC_LOG_ERROR("Invalid listen address %s: %s", address.c_str(), error.message().c_str());
+        return false;
+    }
+
+    acceptor.open(endpoint.protocol(), error);
+    if (!error)
+        acceptor.set_option(asio::ip::tcp::acceptor::reuse_address(true), error);
+    if (!error)
+        acceptor.bind(endpoint, error);
+    if (!error)
+        acceptor.listen(asio::socket_base::max_listen_connections, error);
+
+    if (error)
+    {
+        NC_LOG_ERROR("Failed to listen on %s:%u: %s", address.c_str(), (u32)port, error.message().c_str());
+        return false;
+    }
+
+    return true;
+}
+
+void MockServer::Stop()
+{
+    asio::post(_strand, [this]()
+    {
+        asio::error_code error;
+        _acceptor.close(error);
+        _worldAcceptor.close(error);
+        _sweepTimer.cancel();
+    });
+}
+
+void MockServer::AddRealm(std::string const& name, std::string const& address, u8 id)
+{
+    _realms.push_back({ name, address, id });
+}
+
+void MockServer::BuildRealmListPacket()
+{
+    ByteBuffer body(256);
+    body.Write<u32>(0);
+    body.Write<u16>(static_cast<u16>(_realms.size()));
+
+    for (MockRealm const& realm : _realms)
+    {
+        body.Write<u8>(0); // Type
+        body.Write<u8>(0); // Locked
+        body.Write<u8>(REALM_FLAG_NONE);
+        body.WriteString(realm.name);
+        body.WriteString(realm.address);
+        body.Write<f32>(0.0f); // Population
+        body.Write<u8>(0); // Characters
+        body.Write<u8>(1); // Timezone
+        body.Write<u8>(realm.id);
+    }
+    body.Write<u8>(0x10);
+    body.Write<u8>(0x00);
+
+    ByteBuffer packet(body.GetActualSize() + 3);
+    packet.Write<u8>(NOVUS_REALM_LIST);
+    packet.Write<u16>(static_cast<u16>(body.GetActualSize()));
+    packet.Append(body);
+
+    _realmListPacket.assign(packet.GetReadPointer(), packet.GetReadPointer() + packet.GetActualSize());
+}
+
+size_t MockServer::GetSessionCount()
+{
+    std::lock_guard<std::mutex> lock(_sessionMutex);
+    return _sessions.size();
+}
+
+void MockServer::AsyncAccept(bool isWorld)
+{
+    asio::ip::tcp::acceptor& acceptor = isWorld ? _worldAcceptor : _acceptor;
+    asio::ip::tcp::socket* socket = new asio::ip::tcp::socket(_ioService);
+    acceptor.async_accept(*socket, asio::bind_executor(_strand, std::bind(&MockServer::HandleAccept, this, socket, isWorld, std::placeholders::_1)));
+}
+
+void MockServer::HandleAccept(asio::ip::tcp::socket* socket, bool isWorld, asio::error_code error)
+{
+    if (error)
+    {
+        delete socket;
+
+        // The acceptor only errors out for good once it has been closed
+        if ((isWorld ? _worldAcceptor : _acceptor).is_open())
+            AsyncAccept(isWorld);
+        return;
+    }
+
+    socket->set_option(asio::ip::tcp::no_delay(true), error);
+
+    MockSession* session = nullptr;
+    if (isWorld)
+    {
+        _stats.worldAccepted++;
+        session = new MockWorldSession(socket, _accountTable, _stats, _processingDelay, _worldBulkPacketSize);
+    }
+    else
+    {
+        _stats.accepted++;
+        session = new MockAuthSession(socket, _accountTable, _stats, _realmListPacket, _processingDelay);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_sessionMutex);
+        _sessions.emplace_back(session);
+    }
+    session->Start();
+
+    AsyncAccept(isWorld);
+}
+
+void MockServer::ScheduleSweep()
+{
+    _sweepTimer.expires_after(std::chrono::milliseconds(SWEEP_INTERVAL));
+    _sweepTimer.async_wait(asio::bind_executor(_strand, std::bind(&MockServer::HandleSweep, this, std::placeholders::_1)));
+}
+
+void MockServer::HandleSweep(asio::error_code error)
+{
+    if (error)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(_sessionMutex);
+        _finishedSessions.clear();
+
+        for (size_t i = 0; i < _sessions.size();)
+        {
+            if (_sessions[i]->IsFinished())
+            {
+                _finishedSessions.push_back(std::move(_sessions[i]));
+                _sessions[i] = std::move(_sessions.back());
+                _sessions.pop_back();
+            }
+            else
+            {
+                i++;
+            }
+        }
+    }
+
+    ScheduleSweep();
+}
\ No newline at end of file
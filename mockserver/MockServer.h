@@ -0,0 +1,89 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <asio.hpp>
+#include "NovusTypes.h"
+#include "AccountTable.h"
+#include "MockAuthSession.h"
+#include "MockWorldSession.h"
+
+// Accepts auth and world connections and owns their sessions, finished sessions are reaped by a periodic sweep
+class MockServer
+{
+public:
+    MockServer(asio::io_service& ioService, AccountTable& accountTable);
+    ~MockServer();
+
+    bool Start(std::string const& address, u16 port, u16 worldPort, u32 processingDelay);
+    // Size of an extra SMSG_COMPRESSED_UPDATE_OBJECT sent with the world auth response, 0 disables it
+    void SetWorldBulkPacketSize(u32 size) { _worldBulkPacketSize = size; }
+    // Every session answers REALM_LIST with the same prebuilt packet, realm addresses are sent as host:port
+    void AddRealm(std::string const& name, std::string const& address, u8 id);
+    void Stop();
+
+    MockServerStats const& GetStats() const { return _stats; }
+    size_t GetSessionCount();
+
+private:
+    bool Listen(asio::ip::tcp::acceptor& acceptor, std::string const& address, u16 port);
+    void AsyncAccept(bool isWorld);
+    void HandleAccept(asio::ip::tcp::socket* socket, bool isWorld, asio::error_code error);
+
+    void BuildRealmListPacket();
+
+    void ScheduleSweep();
+    void HandleSweep(asio::error_code error);
+
+private:
+    asio::io_service& _ioService;
+    // Accepting and sweeping run on their own strand since the acceptor isn't thread safe
+    asio::io_service::strand _strand;
+    asio::ip::tcp::acceptor _acceptor;
+    asio::ip::tcp::acceptor _worldAcceptor;
+    asio::steady_timer _sweepTimer;
+    AccountTable& _accountTable;
+    u32 _processingDelay;
+    u32 _worldBulkPacketSize;
+
+    MockServerStats _stats;
+
+    struct MockRealm
+    {
+        std::string name;
+        std::string address;
+        u8 id;
+    };
+    std::vector<MockRealm> _realms;
+    std::vector<u8> _realmListPacket;
+
+    std::mutex _sessionMutex;
+    std::vector<std::unique_ptr<MockSession>> _sessions;
+    // Sessions that finished before the last sweep, freed one sweep later so their aborted handlers have run
+    std::vector<std::unique_ptr<MockSession>> _finishedSessions;
+};
\ No newline at end of file
@@ -0,0 +1,69 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+
+#include "MockSession.h"
+
+MockSession::MockSession(asio::ip::tcp::socket* socket, MockServerStats& stats, u32 processingDelay, size_t receiveBufferSize)
+    : Common::BaseSocket(socket, receiveBufferSize), _stats(stats), _processingDelay(processingDelay), _isFinished(false), _delayTimer() { }
+
+void MockSession::Start()
+{
+    asio::post(_strand, [this]()
+    {
+        AsyncRead();
+    });
+}
+
+void MockSession::Close(asio::error_code error)
+{
+    if (_delayTimer)
+        _delayTimer->cancel();
+
+    if (!_isClosed)
+        Common::BaseSocket::Close(error);
+
+    _isFinished = true;
+}
+
+void MockSession::SendResponse(ByteBuffer&& packet)
+{
+    if (_processingDelay == 0)
+    {
+        Send(std::move(packet));
+        return;
+    }
+
+    // The ByteBuffer is shared so the handler stays copyable
+    std::shared_ptr<ByteBuffer> delayedPacket = std::make_shared<ByteBuffer>(std::move(packet));
+
+    if (!_delayTimer)
+        _delayTimer = std::make_unique<asio::steady_timer>(_socket->get_executor().context());
+
+    _delayTimer->expires_after(std::chrono::milliseconds(_processingDelay));
+    _delayTimer->async_wait(asio::bind_executor(_strand, [this, delayedPacket](asio::error_code error)
+    {
+        if (!error && !_isClosed)
+            Send(std::move(*delayedPacket));
+    }));
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <asio.hpp>
+#include "NovusTypes.h"
+#include "Networking/BaseSocket.h"
+
+struct MockServerStats
+{
+    std::atomic<u64> accepted;
+    std::atomic<u64> challenges;
+    std::atomic<u64> authed;
+    std::atomic<u64> failed;
+    std::atomic<u64> realmLists;
+    std::atomic<u64> worldAccepted;
+    std::atomic<u64> worldAuthed;
+    // Everything received after the world login, replayed traffic ends up here
+    std::atomic<u64> worldPackets;
+};
+
+// Shared part of the auth and world sessions, the server frees a session some time after it reports itself finished
+class MockSession : public Common::BaseSocket
+{
+public:
+    MockSession(asio::ip::tcp::socket* socket, MockServerStats& stats, u32 processingDelay, size_t receiveBufferSize = 4096);
+
+    virtual void Start();
+    void Close(asio::error_code error) override;
+
+    bool IsFinished() const { return _isFinished.load(); }
+
+protected:
+    // Sends right away or after the configured processing delay, the delay stands in for the real server's database work
+    // Both protocols are strictly request/response during login so a single timer per session is enough
+    void SendResponse(ByteBuffer&& packet);
+
+    MockServerStats& _stats;
+
+private:
+    u32 _processingDelay;
+    std::atomic<bool> _isFinished;
+    std::unique_ptr<asio::steady_timer> _delayTimer;
+};
\ No newline at end of file
@@ -0,0 +1,211 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+
+#include "MockWorldSession.h"
+#include "Networking/Opcode/Opcode.h"
+#include "Cryptography/SHA1.h"
+#include "Utils/DebugHandler.h"
+#include <cstring>
+#include <vector>
+
+constexpr size_t CLIENT_HEADER_SIZE = 6;
+
+enum MockWorldAuthResult
+{
+    MOCK_AUTH_OK        = 0x0C,
+    MOCK_AUTH_FAILED    = 0x0D
+};
+
+MockWorldSession::MockWorldSession(asio::ip::tcp::socket* socket, AccountTable& accountTable, MockServerStats& stats, u32 processingDelay, u32 bulkPacketSize)
+    : MockSession(socket, stats, processingDelay), _accountTable(accountTable), _crypto(), _serverSeed(0), _bulkPacketSize(bulkPacketSize), _isAuthed(false),
+    _hasHeader(false), _opcode(0), _bodySize(0) { }
+
+void MockWorldSession::Start()
+{
+    asio::post(_strand, [this]()
+    {
+        _serverSeed = static_cast<u32>(rand()) ^ (static_cast<u32>(rand()) << 16);
+
+        u8 challenge[40];
+        std::memset(challenge, 0, sizeof(challenge));
+        u32 unknown = 1;
+        std::memcpy(challenge, &unknown, 4);
+        std::memcpy(challenge + 4, &_serverSeed, 4);
+
+        ByteBuffer packet(64);
+        WritePacket(packet, Common::SMSG_AUTH_CHALLENGE, challenge, sizeof(challenge));
+        Send(std::move(packet));
+
+        AsyncRead();
+    });
+}
+
+void MockWorldSession::HandleRead()
+{
+    RingBuffer& receiveBuffer = GetReceiveBuffer();
+    while (receiveBuffer.GetActualSize())
+    {
+        if (!_hasHeader)
+        {
+            if (receiveBuffer.GetActualSize() < CLIENT_HEADER_SIZE)
+                break;
+
+            for (size_t i = 0; i < CLIENT_HEADER_SIZE; i++)
+                _crypto.Decrypt(&receiveBuffer.At(i), 1);
+
+            u32 size = (u32(receiveBuffer.At(0)) << 8) | receiveBuffer.At(1);
+            _opcode = u16(receiveBuffer.At(2) | (receiveBuffer.At(3) << 8));
+            if (size < 4)
+            {
+                Close(asio::error::message_size);
+                return;
+            }
+
+            _bodySize = size - 4;
+            _hasHeader = true;
+        }
+
+        size_t packetSize = CLIENT_HEADER_SIZE + _bodySize;
+        if (packetSize > receiveBuffer.GetCapacity())
+        {
+            Close(asio::error::message_size);
+            return;
+        }
+
+        if (receiveBuffer.GetActualSize() < packetSize)
+            break;
+
+        if (!receiveBuffer.Linearize(packetSize))
+        {
+            Close(asio::error::message_size);
+            return;
+        }
+
+        // Only the login is handled, everything the client sends afterwards is read and dropped
+        if (_opcode == Common::CMSG_AUTH_SESSION && !_isAuthed)
+        {
+            if (!HandleAuthSession(receiveBuffer.GetReadPointer() + CLIENT_HEADER_SIZE, _bodySize))
+            {
+                _stats.failed++;
+                if (_isClosed)
+                    return;
+            }
+        }
+        else if (_isAuthed)
+        {
+            _stats.worldPackets++;
+        }
+
+        receiveBuffer.ReadBytes(packetSize);
+        _hasHeader = false;
+    }
+
+    AsyncRead();
+}
+
+bool MockWorldSession::HandleAuthSession(u8* data, u32 size)
+{
+    // Build and login server id come before the account name
+    if (size < 9)
+    {
+        Close(asio::error::message_size);
+        return false;
+    }
+
+    char const* account = reinterpret_cast<char const*>(data + 8);
+    u8 const* accountEnd = static_cast<u8 const*>(std::memchr(account, 0, size - 8));
+
+    // Login server type, client seed, region, battlegroup, realm, dos response and the digest follow the name
+    constexpr size_t trailerSize = 4 + 4 + 4 + 4 + 4 + 8 + 20;
+    if (!accountEnd || static_cast<size_t>(data + size - (accountEnd + 1)) < trailerSize)
+    {
+        Close(asio::error::message_size);
+        return false;
+    }
+
+    std::string username(account, reinterpret_cast<char const*>(accountEnd));
+    u8 const* trailer = accountEnd + 1;
+
+    u32 clientSeed;
+    std::memcpy(&clientSeed, trailer + 4, 4);
+    u8 const* digest = trailer + 4 + 4 + 4 + 4 + 4 + 8;
+
+    BigNumber sessionKey;
+    bool isValid = _accountTable.GetSessionKey(username, sessionKey);
+    if (isValid)
+    {
+        u32 zero = 0;
+        SHA1Hasher sha;
+        sha.UpdateHash(username);
+        sha.UpdateHash(reinterpret_cast<u8 const*>(&zero), 4);
+        sha.UpdateHash(reinterpret_cast<u8 const*>(&clientSeed), 4);
+        sha.UpdateHash(reinterpret_cast<u8 const*>(&_serverSeed), 4);
+        sha.UpdateHashForBn(1, &sessionKey);
+        sha.Finish();
+
+        isValid = std::memcmp(sha.GetData(), digest, 20) == 0;
+    }
+
+    if (!isValid)
+    {
+        u8 result = MOCK_AUTH_FAILED;
+        ByteBuffer packet(8);
+        WritePacket(packet, Common::SMSG_AUTH_RESPONSE, &result, 1);
+        SendResponse(std::move(packet));
+        return false;
+    }
+
+    // Everything after CMSG_AUTH_SESSION has its headers encrypted in both directions
+    _crypto.SetupServer(&sessionKey);
+    _isAuthed = true;
+    _stats.worldAuthed++;
+
+    u8 authResponse[11];
+    std::memset(authResponse, 0, sizeof(authResponse));
+    authResponse[0] = MOCK_AUTH_OK;
+    authResponse[10] = 2; // Expansion
+
+    ByteBuffer packet(64 + _bulkPacketSize);
+    WritePacket(packet, Common::SMSG_AUTH_RESPONSE, authResponse, sizeof(authResponse));
+
+    // Optional filler packet after the login, big enough sizes exercise the client's 3 byte header and large packet path
+    if (_bulkPacketSize > 0)
+    {
+        std::vector<u8> bulk(_bulkPacketSize, 0);
+        WritePacket(packet, Common::SMSG_COMPRESSED_UPDATE_OBJECT, bulk.data(), _bulkPacketSize);
+    }
+
+    SendResponse(std::move(packet));
+    return true;
+}
+
+void MockWorldSession::WritePacket(ByteBuffer& buffer, u16 opcode, u8 const* body, u32 size)
+{
+    Common::ServerPacketHeader header(size + 2, opcode);
+    _crypto.Encrypt(header.headerArray, header.GetLength());
+
+    buffer.Append(header.headerArray, header.GetLength());
+    if (size)
+        buffer.Append(body, size);
+}
\ No newline at end of file
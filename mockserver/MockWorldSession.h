@@ -0,0 +1,60 @@
+/*
+# MIT License
+
+# Copyright(c) 2018-2019 NovusCore
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+*/
+#pragma once
+
+#include <string>
+#include <asio.hpp>
+#include "NovusTypes.h"
+#include "Cryptography/BigNumber.h"
+#include "Cryptography/StreamCrypto.h"
+#include "MockSession.h"
+#include "AccountTable.h"
+
+// Server side of the world login, SMSG_AUTH_CHALLENGE/CMSG_AUTH_SESSION and the header encryption that follows
+class MockWorldSession : public MockSession
+{
+public:
+    MockWorldSession(asio::ip::tcp::socket* socket, AccountTable& accountTable, MockServerStats& stats, u32 processingDelay, u32 bulkPacketSize);
+
+    void Start() override;
+    void HandleRead() override;
+
+private:
+    bool HandleAuthSession(u8* data, u32 size);
+
+    // Appends a packet with its header encrypted in place, several packets can be batched into one response
+    void WritePacket(ByteBuffer& buffer, u16 opcode, u8 const* body, u32 size);
+
+private:
+    AccountTable& _accountTable;
+    StreamCrypto _crypto;
+    u32 _serverSeed;
+    u32 _bulkPacketSize;
+    bool _isAuthed;
+
+    // Client headers are always 6 bytes and are decrypted as soon as they are complete
+    bool _hasHeader;
+    u16 _opcode;
+    u32 _bodySize;
+};
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include <iostream>
+#include <string>
+#include <algorithm>
+#include <asio.hpp>
+
+#include "Networking/IOThreadPool.h"
+#include "Networking/BufferPool.h"
+#include "Config/ConfigHandler.h"
+#include "Utils/DebugHandler.h"
+#include "AccountTable.h"
+#include "MockServer.h"
+
+void PrintStats(MockServer& server, AccountTable& accountTable)
+{
+    MockServerStats const& stats = server.GetStats();
+    NC_LOG_MESSAGE("Mockserver: %llu accepted, %llu challenges, %llu authed, %llu realmlists, %llu failed, %u open sessions, %u accounts",
+        stats.accepted.load(), stats.challenges.load(), stats.authed.load(), stats.realmLists.load(), stats.failed.load(), (u32)server.GetSessionCount(), (u32)accountTable.GetAccountCount());
+    NC_LOG_MESSAGE("Mockserver: World %llu accepted, %llu authed, %llu packets", stats.worldAccepted.load(), stats.worldAuthed.load(), stats.worldPackets.load());
+    NC_LOG_MESSAGE("Mockserver: Buffers %llu hits, %llu misses, %llu oversized", BufferPool::GetHits(), BufferPool::GetMisses(), BufferPool::GetOversized());
+}
+
+i32 main()
+{
+    /* Load Config Handler for mockserver */
+    if (!ConfigHandler::Load("mockserver_configuration.json"))
+    {
+        std::getchar();
+        return 0;
+    }
+
+    AccountTable accountTable;
+    std::string usernamePrefix = ConfigHandler::GetOption<std::string>("accountUsernamePrefix", "bot");
+    std::string password = ConfigHandler::GetOption<std::string>("accountPassword", "password");
+    u32 accountCount = ConfigHandler::GetOption<u32>("accountCount", 1000);
+
+    accountTable.Populate(usernamePrefix, password, accountCount);
+    accountTable.SetAutoCreate(ConfigHandler::GetOption<bool>("autoCreateAccounts", true), password);
+    NC_LOG_MESSAGE("Mockserver: Created %u accounts", accountCount);
+
+    u32 ioThreadCount = IOThreadPool::GetThreadCount(ConfigHandler::GetOption<u32>("ioThreads", 0));
+    asio::io_service io_service(ioThreadCount);
+
+    MockServer server(io_service, accountTable);
+    std::string address = ConfigHandler::GetOption<std::string>("address", "127.0.0.1");
+    u16 port = ConfigHandler::GetOption<u16>("port", 3724);
+    u16 worldPort = ConfigHandler::GetOption<u16>("worldPort", 8085);
+    server.AddRealm(ConfigHandler::GetOption<std::string>("realmName", "NovusCore"), ConfigHandler::GetOption<std::string>("realmAddress", "127.0.0.1:8085"), 1);
+    server.SetWorldBulkPacketSize(ConfigHandler::GetOption<u32>("worldBulkPacketSize", 0));
+    if (!server.Start(address, port, worldPort, ConfigHandler::GetOption<u32>("processingDelay", 0)))
+    {
+        std::getchar();
+        return 0;
+    }
+
+    IOThreadPool ioThreadPool(io_service);
+    ioThreadPool.Start(ioThreadCount);
+
+    NC_LOG_SUCCESS("Mockserver: Listening on %s:%u, world on %s:%u", address.c_str(), (u32)port, address.c_str(), (u32)worldPort);
+
+    std::string command;
+    while (std::getline(std::cin, command))
+    {
+        std::transform(command.begin(), command.end(), command.begin(), ::tolower);
+
+        if (command == "quit")
+            break;
+
+        if (command == "stats")
+            PrintStats(server, accountTable);
+    }
+
+    server.Stop();
+    ioThreadPool.Stop();
+    PrintStats(server, accountTable);
+
+    return 0;
+}
\ No newline at end of file